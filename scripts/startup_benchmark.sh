@@ -0,0 +1,51 @@
+#!/usr/bin/env bash
+#
+# Repeatedly starts quasselclient in --startup-benchmark mode and reports the median duration
+# of each startup phase. The client connects to the last used core account of the given config
+# dir, so that account must be set up to log in without user interaction (e.g. a local core with
+# a remembered password).
+#
+# Usage: startup_benchmark.sh <path/to/quasselclient> <configdir> [runs]
+#
+# Runs in which the client doesn't become usable within --startup-benchmark-timeout are reported
+# and left out of the statistics.
+#
+# With Qt5, the client runs headless on the offscreen platform plugin unless QT_QPA_PLATFORM is set.
+
+client="$1"
+configdir="$2"
+runs="${3:-10}"
+
+if [ -z "$client" ] || [ -z "$configdir" ]; then
+    echo "Usage: $0 <path/to/quasselclient> <configdir> [runs]" >&2
+    exit 1
+fi
+
+export QT_QPA_PLATFORM="${QT_QPA_PLATFORM:-offscreen}"
+
+results=$(mktemp)
+trap 'rm -f "$results"' EXIT
+
+for run in $(seq 1 "$runs"); do
+    echo "Run $run of $runs..." >&2
+    # timeline lines look like "   12.3 -    45.6      (33.3 ms)  Phase name"
+    output=$("$client" -c "$configdir" --startup-benchmark 2>/dev/null)
+    if [ $? -ne 0 ]; then
+        # the client gave up waiting; show what it got to, but keep it out of the statistics
+        echo "Run $run did not complete:" >&2
+        echo "$output" >&2
+        continue
+    fi
+    echo "$output" | sed -n 's/^ *[0-9.]* - *[0-9.]* *(\([0-9.]*\) ms) *\(.*\)$/\2\t\1/p' >> "$results"
+done
+
+printf "%-40s %10s %10s %10s\n" "Phase" "min ms" "median ms" "max ms"
+cut -f1 "$results" | awk '!seen[$0]++' | while IFS= read -r phase; do
+    grep -F "$phase	" "$results" | cut -f2 | sort -n | awk -v phase="$phase" '
+        { values[NR] = $1 }
+        END {
+            if (NR % 2) median = values[(NR + 1) / 2]
+            else median = (values[NR / 2] + values[NR / 2 + 1]) / 2
+            printf "%-40s %10.1f %10.1f %10.1f\n", phase, values[1], median, values[NR]
+        }'
+done
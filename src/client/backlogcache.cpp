@@ -0,0 +1,196 @@
+/***************************************************************************
+ *   Copyright (C) 2005-2015 by the Quassel Project                        *
+ *   devel@quassel-irc.org                                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3.                                           *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.         *
+ ***************************************************************************/
+
+#include "backlogcache.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QSet>
+#include <QtAlgorithms>
+
+const quint32 cacheMagic = 0x51424c43; // "QBLC"
+const quint32 cacheVersion = 1;
+
+BacklogCache::BacklogCache(const QString &path, int maxMessagesPerBuffer)
+    : _dir(path),
+    _maxMessages(maxMessagesPerBuffer)
+{
+    if (!_dir.exists() && !_dir.mkpath(_dir.absolutePath()))
+        qWarning() << "BacklogCache: could not create cache directory" << _dir.absolutePath();
+}
+
+
+QString BacklogCache::fileName(BufferId bufferId) const
+{
+    return _dir.absoluteFilePath(QString("%1.backlog").arg(bufferId.toInt()));
+}
+
+
+void BacklogCache::validate(const BufferIdList &knownBuffers)
+{
+    QSet<BufferId> known = knownBuffers.toSet();
+    foreach(const QString &entry, _dir.entryList(QStringList() << "*.backlog", QDir::Files)) {
+        bool ok;
+        BufferId bufferId = entry.section('.', 0, 0).toInt(&ok);
+        if (!ok || !known.contains(bufferId)) {
+            _dir.remove(entry);
+            _lastMsgIds.remove(bufferId);
+            _messageCounts.remove(bufferId);
+        }
+    }
+}
+
+
+MessageList BacklogCache::messages(BufferId bufferId)
+{
+    MessageList messages;
+    QFile file(fileName(bufferId));
+    if (!file.open(QIODevice::ReadOnly)) {
+        // nothing cached yet, but from now on we know the buffer's state
+        _lastMsgIds[bufferId] = MsgId();
+        _messageCounts[bufferId] = 0;
+        return messages;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_4_2);
+    quint32 magic, version;
+    in >> magic >> version;
+    bool valid = in.status() == QDataStream::Ok && magic == cacheMagic && version == cacheVersion;
+
+    MsgId lastMsgId;
+    while (valid && !in.atEnd()) {
+        Message msg;
+        in >> msg;
+        // messages must be stored for the right buffer and in strictly ascending order
+        if (in.status() != QDataStream::Ok || msg.bufferId() != bufferId || msg.msgId() <= lastMsgId) {
+            valid = false;
+            break;
+        }
+        lastMsgId = msg.msgId();
+        messages << msg;
+    }
+    file.close();
+
+    if (!valid) {
+        qWarning() << "BacklogCache: dropping corrupt cache file" << file.fileName();
+        remove(bufferId);
+        _lastMsgIds[bufferId] = MsgId();
+        _messageCounts[bufferId] = 0;
+        return MessageList();
+    }
+
+    _lastMsgIds[bufferId] = lastMsgId;
+    _messageCounts[bufferId] = messages.count();
+    return messages;
+}
+
+
+MessageList BacklogCache::sorted(const MessageList &messages)
+{
+    MessageList result = messages;
+    qSort(result);
+    return result;
+}
+
+
+void BacklogCache::append(BufferId bufferId, const MessageList &messages)
+{
+    if (!isLoaded(bufferId)) {
+        qWarning() << "BacklogCache::append(): state of buffer" << bufferId << "is unknown";
+        return;
+    }
+
+    MsgId lastMsgId = _lastMsgIds[bufferId];
+    MessageList newMessages;
+    foreach(const Message &msg, sorted(messages)) {
+        if (msg.msgId() > lastMsgId && msg.bufferId() == bufferId) {
+            newMessages << msg;
+            lastMsgId = msg.msgId();
+        }
+    }
+    if (newMessages.isEmpty())
+        return;
+
+    if (_messageCounts[bufferId] + newMessages.count() > 2 * _maxMessages) {
+        // compact: rewrite the file with only the most recent messages
+        MessageList all = this->messages(bufferId);
+        all << newMessages;
+        replace(bufferId, all);
+        return;
+    }
+
+    if (writeMessages(bufferId, newMessages, false)) {
+        _lastMsgIds[bufferId] = lastMsgId;
+        _messageCounts[bufferId] += newMessages.count();
+    }
+}
+
+
+void BacklogCache::replace(BufferId bufferId, const MessageList &messages)
+{
+    MessageList newMessages;
+    foreach(const Message &msg, sorted(messages)) {
+        if (msg.bufferId() == bufferId && (newMessages.isEmpty() || msg.msgId() > newMessages.last().msgId()))
+            newMessages << msg;
+    }
+    if (newMessages.count() > _maxMessages)
+        newMessages = newMessages.mid(newMessages.count() - _maxMessages);
+
+    if (writeMessages(bufferId, newMessages, true)) {
+        _lastMsgIds[bufferId] = newMessages.isEmpty() ? MsgId() : newMessages.last().msgId();
+        _messageCounts[bufferId] = newMessages.count();
+    }
+    else {
+        remove(bufferId);
+    }
+}
+
+
+void BacklogCache::remove(BufferId bufferId)
+{
+    QFile::remove(fileName(bufferId));
+    _lastMsgIds.remove(bufferId);
+    _messageCounts.remove(bufferId);
+}
+
+
+bool BacklogCache::writeMessages(BufferId bufferId, const MessageList &messages, bool truncate)
+{
+    QFile file(fileName(bufferId));
+    bool newFile = truncate || !file.exists();
+    if (!file.open(newFile ? QIODevice::WriteOnly | QIODevice::Truncate : QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "BacklogCache: could not open" << file.fileName() << "for writing:" << file.errorString();
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_4_2);
+    if (newFile)
+        out << cacheMagic << cacheVersion;
+
+    foreach(const Message &msg, messages) {
+        // the flag is added on the client side when receiving backlog, don't persist it
+        Message stored = msg;
+        stored.setFlags(msg.flags() & ~Message::Backlog);
+        out << stored;
+    }
+    return out.status() == QDataStream::Ok && file.error() == QFile::NoError;
+}
@@ -0,0 +1,73 @@
+/***************************************************************************
+ *   Copyright (C) 2005-2015 by the Quassel Project                        *
+ *   devel@quassel-irc.org                                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3.                                           *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.         *
+ ***************************************************************************/
+
+#ifndef BACKLOGCACHE_H
+#define BACKLOGCACHE_H
+
+#include <QDir>
+#include <QHash>
+
+#include "message.h"
+#include "types.h"
+
+//! Keeps the most recent messages of each buffer on disk
+/** The cache holds one append-only file per buffer in a directory specific to the core account.
+ *  Each file starts with a small header, followed by the serialized messages in ascending MsgId
+ *  order. Files are compacted to the configured number of messages once they grow to twice that
+ *  size. Files that are unreadable or belong to buffers the core doesn't know are removed.
+ *
+ *  Appending is only allowed for buffers whose state is known, i.e. after they have been loaded
+ *  with messages() or written with replace().
+ */
+class BacklogCache
+{
+public:
+    BacklogCache(const QString &path, int maxMessagesPerBuffer);
+
+    //! Removes all cache files of buffers not contained in knownBuffers
+    void validate(const BufferIdList &knownBuffers);
+
+    //! Loads the cached messages of a buffer, in ascending MsgId order
+    MessageList messages(BufferId bufferId);
+
+    inline bool isLoaded(BufferId bufferId) const { return _lastMsgIds.contains(bufferId); }
+    inline MsgId lastMsgId(BufferId bufferId) const { return _lastMsgIds.value(bufferId); }
+
+    //! Appends messages newer than the last cached one
+    void append(BufferId bufferId, const MessageList &messages);
+
+    //! Replaces the cached messages of a buffer
+    void replace(BufferId bufferId, const MessageList &messages);
+
+    void remove(BufferId bufferId);
+
+private:
+    QString fileName(BufferId bufferId) const;
+    bool writeMessages(BufferId bufferId, const MessageList &messages, bool truncate);
+    static MessageList sorted(const MessageList &messages);
+
+    QDir _dir;
+    int _maxMessages;
+    QHash<BufferId, MsgId> _lastMsgIds;
+    QHash<BufferId, int> _messageCounts;
+};
+
+
+#endif //BACKLOGCACHE_H
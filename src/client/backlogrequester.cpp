@@ -23,6 +23,7 @@
 #include <QObject>
 
 #include "backlogsettings.h"
+#include "buffermodel.h"
 #include "bufferviewoverlay.h"
 #include "clientbacklogmanager.h"
 
@@ -33,27 +34,73 @@ BacklogRequester::BacklogRequester(bool buffering, RequesterType requesterType,
     _totalBuffers(0)
 {
     Q_ASSERT(backlogManager);
+    BacklogSettings backlogSettings;
+    _maxRequestsInFlight = backlogSettings.maxRequestsInFlight();
 }
 
 
-void BacklogRequester::setWaitingBuffers(const QSet<BufferId> &buffers)
+void BacklogRequester::enqueueBuffers(const BufferIdList &bufferIds)
 {
-    _buffersWaiting = buffers;
-    _totalBuffers = _buffersWaiting.count();
+    if (_buffersWaiting.isEmpty())
+        _totalBuffers = 0;
+
+    foreach(BufferId bufferId, bufferIds) {
+        if (_buffersWaiting.contains(bufferId))
+            continue;
+        _buffersWaiting << bufferId;
+        _requestQueue << bufferId;
+        _totalBuffers++;
+    }
+
+    // (re)sort the whole queue, since the current buffer or activities may have changed in the meantime
+    BufferId currentBuffer = Client::bufferModel()->currentBuffer();
+    const QSet<BufferId> &visibleBuffers = Client::bufferViewOverlay()->bufferIds();
+    QList<BufferIdList> queues;
+    for (int i = CurrentBufferPriority; i <= OtherPriority; i++)
+        queues << BufferIdList();
+    foreach(BufferId bufferId, _requestQueue) {
+        queues[priority(bufferId, currentBuffer, visibleBuffers)] << bufferId;
+    }
+    _requestQueue.clear();
+    foreach(const BufferIdList &queue, queues) {
+        _requestQueue << queue;
+    }
+
+    dispatchRequests();
 }
 
 
-void BacklogRequester::addWaitingBuffer(BufferId buffer)
+BacklogRequester::RequestPriority BacklogRequester::priority(BufferId bufferId, BufferId currentBuffer, const QSet<BufferId> &visibleBuffers) const
 {
-    _buffersWaiting << buffer;
-    _totalBuffers++;
+    if (bufferId == currentBuffer)
+        return CurrentBufferPriority;
+
+    BufferInfo::ActivityLevel activity = Client::networkModel()->bufferActivity(bufferId);
+    if (activity & BufferInfo::Highlight)
+        return HighlightPriority;
+    if (activity & BufferInfo::NewMessage)
+        return UnreadPriority;
+    if (visibleBuffers.contains(bufferId))
+        return VisiblePriority;
+    return OtherPriority;
 }
 
 
-bool BacklogRequester::buffer(BufferId bufferId, const MessageList &messages)
+void BacklogRequester::dispatchRequests()
 {
-    _bufferedMessages << messages;
+    while (!_requestQueue.isEmpty() && (_maxRequestsInFlight <= 0 || _buffersInFlight.count() < _maxRequestsInFlight)) {
+        BufferId bufferId = _requestQueue.takeFirst();
+        _buffersInFlight << bufferId;
+        fetchBacklog(bufferId);
+    }
+}
+
+
+bool BacklogRequester::receivedBacklog(BufferId bufferId)
+{
+    _buffersInFlight.remove(bufferId);
     _buffersWaiting.remove(bufferId);
+    dispatchRequests();
     return !_buffersWaiting.isEmpty();
 }
 
@@ -66,18 +113,6 @@ BufferIdList BacklogRequester::allBufferIds() const
 }
 
 
-void BacklogRequester::flushBuffer()
-{
-    if (!_buffersWaiting.isEmpty()) {
-        qWarning() << Q_FUNC_INFO << "was called before all backlog was received:"
-                   << _buffersWaiting.count() << "buffers are waiting.";
-    }
-    _bufferedMessages.clear();
-    _totalBuffers = 0;
-    _buffersWaiting.clear();
-}
-
-
 // ========================================
 //  FIXED BACKLOG REQUESTER
 // ========================================
@@ -91,11 +126,14 @@ FixedBacklogRequester::FixedBacklogRequester(ClientBacklogManager *backlogManage
 
 void FixedBacklogRequester::requestBacklog(const BufferIdList &bufferIds)
 {
-    setWaitingBuffers(bufferIds);
     backlogManager->emitMessagesRequested(QObject::tr("Requesting a total of up to %1 backlog messages for %2 buffers").arg(_backlogCount * bufferIds.count()).arg(bufferIds.count()));
-    foreach(BufferId bufferId, bufferIds) {
-        backlogManager->requestBacklog(bufferId, -1, -1, _backlogCount);
-    }
+    enqueueBuffers(bufferIds);
+}
+
+
+void FixedBacklogRequester::fetchBacklog(BufferId bufferId)
+{
+    backlogManager->requestInitialBufferBacklog(bufferId, -1, _backlogCount);
 }
 
 
@@ -138,9 +176,12 @@ PerBufferUnreadBacklogRequester::PerBufferUnreadBacklogRequester(ClientBacklogMa
 
 void PerBufferUnreadBacklogRequester::requestBacklog(const BufferIdList &bufferIds)
 {
-    setWaitingBuffers(bufferIds);
     backlogManager->emitMessagesRequested(QObject::tr("Requesting a total of up to %1 unread backlog messages for %2 buffers").arg((_limit + _additional) * bufferIds.count()).arg(bufferIds.count()));
-    foreach(BufferId bufferId, bufferIds) {
-        backlogManager->requestBacklog(bufferId, Client::networkModel()->lastSeenMsgId(bufferId), -1, _limit, _additional);
-    }
+    enqueueBuffers(bufferIds);
+}
+
+
+void PerBufferUnreadBacklogRequester::fetchBacklog(BufferId bufferId)
+{
+    backlogManager->requestInitialBufferBacklog(bufferId, Client::networkModel()->lastSeenMsgId(bufferId), _limit, _additional);
 }
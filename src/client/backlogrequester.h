@@ -22,6 +22,7 @@
 #define BACKLOGREQUESTER_H
 
 #include <QList>
+#include <QSet>
 
 #include "client.h"
 #include "message.h"
@@ -40,37 +41,53 @@ public:
         GlobalUnread
     };
 
+    //! Order in which per-buffer backlog is fetched; lower values are requested first
+    enum RequestPriority {
+        CurrentBufferPriority = 0,
+        HighlightPriority,
+        UnreadPriority,
+        VisiblePriority,
+        OtherPriority
+    };
+
     BacklogRequester(bool buffering, RequesterType requesterType, ClientBacklogManager *backlogManger);
     virtual inline ~BacklogRequester() {}
 
     inline bool isBuffering() { return _isBuffering; }
     inline RequesterType type() { return _requesterType; }
-    inline const QList<Message> &bufferedMessages() { return _bufferedMessages; }
 
     inline int buffersWaiting() const { return _buffersWaiting.count(); }
     inline int totalBuffers() const { return _totalBuffers; }
 
-    bool buffer(BufferId bufferId, const MessageList &messages); //! returns false if it was the last missing backlogpart
+    //! Marks the backlog of bufferId as received and requests the next queued buffers
+    /** \return false if it was the last missing backlog part */
+    bool receivedBacklog(BufferId bufferId);
 
     virtual void requestBacklog(const BufferIdList &bufferIds) = 0;
     virtual inline void requestInitialBacklog() { requestBacklog(allBufferIds()); }
 
-    virtual void flushBuffer();
-
 protected:
     BufferIdList allBufferIds() const;
-    inline void setWaitingBuffers(const QList<BufferId> &buffers) { setWaitingBuffers(buffers.toSet()); }
-    void setWaitingBuffers(const QSet<BufferId> &buffers);
-    void addWaitingBuffer(BufferId buffer);
+
+    //! Queues the given buffers ordered by RequestPriority and starts requesting their backlog
+    void enqueueBuffers(const BufferIdList &bufferIds);
+
+    //! Issues the actual backlog request for a single buffer
+    virtual inline void fetchBacklog(BufferId bufferId) { Q_UNUSED(bufferId) }
 
     ClientBacklogManager *backlogManager;
 
 private:
+    RequestPriority priority(BufferId bufferId, BufferId currentBuffer, const QSet<BufferId> &visibleBuffers) const;
+    void dispatchRequests();
+
     bool _isBuffering;
     RequesterType _requesterType;
-    MessageList _bufferedMessages;
     int _totalBuffers;
+    int _maxRequestsInFlight;
     QSet<BufferId> _buffersWaiting;
+    QSet<BufferId> _buffersInFlight;
+    BufferIdList _requestQueue;
 };
 
 
@@ -83,6 +100,9 @@ public:
     FixedBacklogRequester(ClientBacklogManager *backlogManager);
     virtual void requestBacklog(const BufferIdList &bufferIds);
 
+protected:
+    virtual void fetchBacklog(BufferId bufferId);
+
 private:
     int _backlogCount;
 };
@@ -113,6 +133,9 @@ public:
     PerBufferUnreadBacklogRequester(ClientBacklogManager *backlogManager);
     virtual void requestBacklog(const BufferIdList &bufferIds);
 
+protected:
+    virtual void fetchBacklog(BufferId bufferId);
+
 private:
     int _limit;
     int _additional;
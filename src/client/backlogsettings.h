@@ -30,6 +30,10 @@ public:
     inline int requesterType() { return localValue("RequesterType", 1).toInt(); }
     inline void setRequesterType(int requesterType) { setLocalValue("RequesterType", requesterType); }
 
+    // Number of per-buffer backlog requests that may be pending at once; 0 means no limit
+    inline int maxRequestsInFlight() { return localValue("MaxRequestsInFlight", 5).toInt(); }
+    inline void setMaxRequestsInFlight(int count) { return setLocalValue("MaxRequestsInFlight", count); }
+
     inline int dynamicBacklogAmount() { return localValue("DynamicBacklogAmount", 200).toInt(); }
     inline void setDynamicBacklogAmount(int amount) { return setLocalValue("DynamicBacklogAmount", amount); }
 
@@ -41,6 +45,12 @@ public:
     inline int globalUnreadBacklogAdditional() { return localValue("GlobalUnreadBacklogAdditional", 100).toInt(); }
     inline void setGlobalUnreadBacklogAdditional(int Additional) { return setLocalValue("GlobalUnreadBacklogAdditional", Additional); }
 
+    // Optional on-disk cache of recent messages, so only newer backlog needs to be fetched on startup
+    inline bool cacheEnabled() { return localValue("CacheEnabled", false).toBool(); }
+    inline void setCacheEnabled(bool enabled) { return setLocalValue("CacheEnabled", enabled); }
+    inline int cacheMaxMessages() { return localValue("CacheMaxMessages", 500).toInt(); }
+    inline void setCacheMaxMessages(int count) { return setLocalValue("CacheMaxMessages", count); }
+
     inline int perBufferUnreadBacklogLimit() { return localValue("PerBufferUnreadBacklogLimit", 200).toInt(); }
     inline void setPerBufferUnreadBacklogLimit(int limit) { return setLocalValue("PerBufferUnreadBacklogLimit", limit); }
     inline int perBufferUnreadBacklogAdditional() { return localValue("PerBufferUnreadBacklogAdditional", 50).toInt(); }
@@ -155,6 +155,8 @@ void Client::init()
 
     p->attachSignal(this, SIGNAL(requestPasswordChange(PeerPtr,QString,QString,QString)), SIGNAL(changePassword(PeerPtr,QString,QString,QString)));
     p->attachSlot(SIGNAL(passwordChanged(PeerPtr,bool)), this, SLOT(corePasswordChanged(PeerPtr,bool)));
+    p->attachSignal(this, SIGNAL(requestSyncInterest(PeerPtr,QVariantList)), SIGNAL(setSyncInterest(PeerPtr,QVariantList)));
+    connect(_bufferViewOverlay, SIGNAL(hasChanged()), SLOT(updateSyncInterest()));
 
     //connect(mainUi(), SIGNAL(connectToCore(const QVariantMap &)), this, SLOT(connectToCore(const QVariantMap &)));
     connect(mainUi(), SIGNAL(disconnectFromCore()), this, SLOT(disconnectFromCore()));
@@ -357,6 +359,27 @@ void Client::sendBufferedUserInput()
 }
 
 
+void Client::updateSyncInterest()
+{
+    if (!isConnected() || !coreFeatures().testFlag(Quassel::SyncInterest) || !_bufferViewOverlay->isInitialized())
+        return;
+
+    // the overlay changes for lots of reasons that don't affect the set of shown buffers
+    const QSet<BufferId> &bufferIds = _bufferViewOverlay->bufferIds();
+    if (bufferIds == _syncInterest)
+        return;
+    _syncInterest = bufferIds;
+
+    QVariantList buffers;
+    foreach(BufferId bufferId, bufferIds) {
+        BufferInfo bufferInfo = networkModel()->bufferInfo(bufferId);
+        if (bufferInfo.isValid())
+            buffers << QVariant::fromValue<BufferInfo>(bufferInfo);
+    }
+    emit requestSyncInterest(nullptr, buffers);
+}
+
+
 /*** core connection stuff ***/
 
 void Client::connectionStateChanged(CoreConnection::ConnectionState state)
@@ -493,6 +516,7 @@ void Client::setDisconnectedFromCore()
 
     // we probably don't want to save pending input for reconnect
     _userInputBuffer.clear();
+    _syncInterest.clear();
 
     _messageModel->clear();
     _networkModel->clear();
@@ -550,6 +574,7 @@ void Client::recvStatusMsg(QString /*net*/, QString /*msg*/)
 
 void Client::recvMessage(const Message &msg)
 {
+    backlogManager()->cacheMessage(msg);
     Message msg_ = msg;
     messageProcessor()->process(msg_);
 }
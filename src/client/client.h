@@ -197,6 +197,9 @@ signals:
     void requestPasswordChange(PeerPtr peer, const QString &userName, const QString &oldPassword, const QString &newPassword);
     void passwordChanged(bool success);
 
+    //! Tells the core which buffers we show, so it can leave out details about users in other ones
+    void requestSyncInterest(PeerPtr peer, const QVariantList &buffers);
+
 public slots:
     void disconnectFromCore();
 
@@ -226,6 +229,8 @@ private slots:
 
     void sendBufferedUserInput();
 
+    void updateSyncInterest();
+
 private:
     Client(QObject *parent = 0);
     virtual ~Client();
@@ -269,6 +274,7 @@ private:
     QTextStream _debugLog;
 
     QList<QPair<BufferInfo, QString> > _userInputBuffer;
+    QSet<BufferId> _syncInterest;
 
     friend class CoreConnection;
 };
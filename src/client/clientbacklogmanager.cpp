@@ -21,20 +21,49 @@
 #include "clientbacklogmanager.h"
 
 #include "abstractmessageprocessor.h"
+#include "backlogcache.h"
 #include "backlogsettings.h"
 #include "backlogrequester.h"
 #include "client.h"
+#include "networkmodel.h"
+#include "startupprofiler.h"
 
 #include <ctime>
 
 #include <QDebug>
+#include <QDir>
+
+// Converts a backlog reply into messages, turning the core's descending msgId order into an ascending one
+static MessageList backlogMessages(const QVariantList &msgs)
+{
+    MessageList msglist;
+    msglist.reserve(msgs.count());
+    for (int i = msgs.count() - 1; i >= 0; i--) {
+        msglist << msgs.at(i).value<Message>();
+        Message &msg = msglist.last();
+        msg.setFlags(msg.flags() | Message::Backlog);
+    }
+    return msglist;
+}
+
 
 INIT_SYNCABLE_OBJECT(ClientBacklogManager)
 ClientBacklogManager::ClientBacklogManager(QObject *parent)
     : BacklogManager(parent),
     _requester(0),
-    _initBacklogRequested(false)
+    _initBacklogRequested(false),
+    _cache(0)
+{
+    _cacheFlushTimer.setSingleShot(true);
+    _cacheFlushTimer.setInterval(10000);
+    connect(&_cacheFlushTimer, SIGNAL(timeout()), this, SLOT(flushCache()));
+}
+
+
+ClientBacklogManager::~ClientBacklogManager()
 {
+    flushCache();
+    delete _cache;
 }
 
 
@@ -47,24 +76,28 @@ QVariantList ClientBacklogManager::requestBacklog(BufferId bufferId, MsgId first
 
 void ClientBacklogManager::receiveBacklog(BufferId bufferId, MsgId first, MsgId last, int limit, int additional, QVariantList msgs)
 {
-    Q_UNUSED(first) Q_UNUSED(last) Q_UNUSED(limit) Q_UNUSED(additional)
+    Q_UNUSED(first) Q_UNUSED(last) Q_UNUSED(additional)
 
     emit messagesReceived(bufferId, msgs.count());
+    StartupProfiler::mark("First backlog received");
 
-    MessageList msglist;
-    foreach(QVariant v, msgs) {
-        Message msg = v.value<Message>();
-        msg.setFlags(msg.flags() | Message::Backlog);
-        msglist << msg;
+    MessageList msglist = backlogMessages(msgs);
+
+    if (_cache && _cacheSyncPending.contains(bufferId)) {
+        MsgId lastCached = _cacheSyncPending.take(bufferId);
+        // if the reply was truncated by the limit, there's a gap between cache and reply
+        if (lastCached.isValid() && (limit < 0 || msgs.count() < limit))
+            _cache->append(bufferId, msglist);
+        else
+            _cache->replace(bufferId, msglist);
     }
 
     if (isBuffering()) {
-        bool lastPart = !_requester->buffer(bufferId, msglist);
+        // hand the backlog to the model right away, so prioritized buffers become usable before everything arrived
+        dispatchMessages(msglist);
+        if (!_requester->receivedBacklog(bufferId))
+            StartupProfiler::end("Initial backlog");
         updateProgress(_requester->totalBuffers() - _requester->buffersWaiting(), _requester->totalBuffers());
-        if (lastPart) {
-            dispatchMessages(_requester->bufferedMessages(), true);
-            _requester->flushBuffer();
-        }
     }
     else {
         dispatchMessages(msglist);
@@ -76,14 +109,10 @@ void ClientBacklogManager::receiveBacklogAll(MsgId first, MsgId last, int limit,
 {
     Q_UNUSED(first) Q_UNUSED(last) Q_UNUSED(limit) Q_UNUSED(additional)
 
-    MessageList msglist;
-    foreach(QVariant v, msgs) {
-        Message msg = v.value<Message>();
-        msg.setFlags(msg.flags() | Message::Backlog);
-        msglist << msg;
-    }
+    MessageList msglist = backlogMessages(msgs);
 
     dispatchMessages(msglist);
+    StartupProfiler::end("Initial backlog");
 }
 
 
@@ -96,6 +125,12 @@ void ClientBacklogManager::requestInitialBacklog()
     }
 
     BacklogSettings settings;
+    if (settings.cacheEnabled() && !Client::internalCore()) {
+        QString path = QDir(Quassel::configDirPath()).absoluteFilePath(QString("backlogcache/%1").arg(Client::currentCoreAccount().accountId().toInt()));
+        _cache = new BacklogCache(path, settings.cacheMaxMessages());
+        _cache->validate(Client::networkModel()->allBufferIds());
+    }
+
     switch (settings.requesterType()) {
     case BacklogRequester::GlobalUnread:
         _requester = new GlobalUnreadBacklogRequester(this);
@@ -108,6 +143,7 @@ void ClientBacklogManager::requestInitialBacklog()
         _requester = new FixedBacklogRequester(this);
     };
 
+    StartupProfiler::begin("Initial backlog");
     _requester->requestInitialBacklog();
     _initBacklogRequested = true;
     if (_requester->isBuffering()) {
@@ -162,16 +198,15 @@ bool ClientBacklogManager::isBuffering()
 }
 
 
-void ClientBacklogManager::dispatchMessages(const MessageList &messages, bool sort)
+void ClientBacklogManager::dispatchMessages(const MessageList &messages)
 {
     if (messages.isEmpty())
         return;
 
+    // no need to sort: the message model merges the ordered runs of each buffer's backlog
     MessageList msgs = messages;
 
     clock_t start_t = clock();
-    if (sort)
-        qSort(msgs);
     Client::messageProcessor()->process(msgs);
     clock_t end_t = clock();
 
@@ -179,10 +214,74 @@ void ClientBacklogManager::dispatchMessages(const MessageList &messages, bool so
 }
 
 
+void ClientBacklogManager::requestInitialBufferBacklog(BufferId bufferId, MsgId first, int limit, int additional)
+{
+    if (!_cache) {
+        requestBacklog(bufferId, first, -1, limit, additional);
+        return;
+    }
+
+    MessageList cached = _cache->messages(bufferId);
+    MsgId lastCached = _cache->lastMsgId(bufferId);
+    _cacheSyncPending[bufferId] = lastCached;
+    if (!lastCached.isValid()) {
+        requestBacklog(bufferId, first, -1, limit, additional);
+        return;
+    }
+
+    // the buffer might have been renamed since the messages were cached
+    BufferInfo bufferInfo = Client::networkModel()->bufferInfo(bufferId);
+    for (int i = 0; i < cached.count(); i++) {
+        Message &msg = cached[i];
+        msg.setFlags(msg.flags() | Message::Backlog);
+        if (bufferInfo.isValid())
+            msg.setBufferInfo(bufferInfo);
+    }
+    Client::messageProcessor()->process(cached);
+
+    // only fetch what has been missed since the cache was written
+    requestBacklog(bufferId, MsgId(lastCached.toInt() + 1), -1, limit + additional);
+}
+
+
+void ClientBacklogManager::cacheMessage(const Message &msg)
+{
+    // buffers still waiting for their initial backlog will get the message with that reply
+    if (!_cache || _cacheSyncPending.contains(msg.bufferId()) || !_cache->isLoaded(msg.bufferId()))
+        return;
+
+    // writing every line of a busy channel right away would mean a file access per message
+    _uncachedMessages[msg.bufferId()] << msg;
+    if (!_cacheFlushTimer.isActive())
+        _cacheFlushTimer.start();
+}
+
+
+void ClientBacklogManager::flushCache()
+{
+    _cacheFlushTimer.stop();
+    if (!_cache) {
+        _uncachedMessages.clear();
+        return;
+    }
+
+    QHash<BufferId, MessageList>::const_iterator it = _uncachedMessages.constBegin();
+    while (it != _uncachedMessages.constEnd()) {
+        _cache->append(it.key(), it.value());
+        ++it;
+    }
+    _uncachedMessages.clear();
+}
+
+
 void ClientBacklogManager::reset()
 {
     delete _requester;
     _requester = 0;
     _initBacklogRequested = false;
     _buffersRequested.clear();
+    flushCache();
+    delete _cache;
+    _cache = 0;
+    _cacheSyncPending.clear();
 }
@@ -21,9 +21,12 @@
 #ifndef CLIENTBACKLOGMANAGER_H
 #define CLIENTBACKLOGMANAGER_H
 
+#include <QTimer>
+
 #include "backlogmanager.h"
 #include "message.h"
 
+class BacklogCache;
 class BacklogRequester;
 
 class ClientBacklogManager : public BacklogManager
@@ -33,12 +36,26 @@ class ClientBacklogManager : public BacklogManager
 
 public:
     ClientBacklogManager(QObject *parent = 0);
+    ~ClientBacklogManager();
 
     // helper for the backlogRequester, as it isn't a QObject and can't emit itself
     inline void emitMessagesRequested(const QString &msg) const { emit messagesRequested(msg); }
 
     void reset();
 
+    //! Requests the initial backlog of a buffer, taking the local backlog cache into account
+    /** If messages of the buffer are cached, they are dispatched right away and only newer
+     *  messages are requested from the core. Otherwise this is equivalent to
+     *  requestBacklog(bufferId, first, -1, limit, additional).
+     */
+    void requestInitialBufferBacklog(BufferId bufferId, MsgId first, int limit, int additional = 0);
+
+    //! Adds a message received from the core to the local backlog cache, if enabled
+    /** Messages are collected in memory and written to disk by flushCache(), which happens
+     *  periodically and on reset().
+     */
+    void cacheMessage(const Message &msg);
+
 public slots:
     virtual QVariantList requestBacklog(BufferId bufferId, MsgId first = -1, MsgId last = -1, int limit = -1, int additional = 0);
     virtual void receiveBacklog(BufferId bufferId, MsgId first, MsgId last, int limit, int additional, QVariantList msgs);
@@ -49,6 +66,9 @@ public slots:
     void checkForBacklog(BufferId bufferId);
     void checkForBacklog(const BufferIdList &bufferIds);
 
+    //! Writes the collected live messages to the local backlog cache
+    void flushCache();
+
 signals:
     void messagesReceived(BufferId bufferId, int count) const;
     void messagesRequested(const QString &) const;
@@ -60,11 +80,16 @@ private:
     bool isBuffering();
     BufferIdList filterNewBufferIds(const BufferIdList &bufferIds);
 
-    void dispatchMessages(const MessageList &messages, bool sort = false);
+    void dispatchMessages(const MessageList &messages);
 
     BacklogRequester *_requester;
     bool _initBacklogRequested;
     QSet<BufferId> _buffersRequested;
+
+    BacklogCache *_cache;
+    QHash<BufferId, MsgId> _cacheSyncPending; // buffers waiting for their initial backlog, with the newest cached MsgId
+    QHash<BufferId, MessageList> _uncachedMessages; // live messages not written to the cache yet
+    QTimer _cacheFlushTimer;
 };
 
 
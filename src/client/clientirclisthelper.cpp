@@ -26,33 +26,112 @@
 #include "irclistmodel.h"
 
 INIT_SYNCABLE_OBJECT(ClientIrcListHelper)
+ClientIrcListHelper::ClientIrcListHelper(QObject *object)
+    : IrcListHelper(object),
+    _paging(false),
+    _pageRequested(false),
+    _listFinished(false),
+    _receivedCount(0)
+{
+    // while the core is still collecting the list, poll for new entries at this interval
+    _pollTimer.setSingleShot(true);
+    _pollTimer.setInterval(500);
+    connect(&_pollTimer, SIGNAL(timeout()), this, SLOT(requestNextPage()));
+}
+
+
 QVariantList ClientIrcListHelper::requestChannelList(const NetworkId &netId, const QStringList &channelFilters)
 {
     _netId = netId;
-    return IrcListHelper::requestChannelList(netId, channelFilters);
+    _channelFilters = channelFilters;
+    _paging = Client::coreFeatures().testFlag(Quassel::PagedChannelList);
+    _pageRequested = false;
+    _listFinished = false;
+    _receivedCount = 0;
+    _pollTimer.stop();
+
+    QVariantList result = IrcListHelper::requestChannelList(netId, channelFilters);
+    if (_paging)
+        requestNextPage();
+    return result;
 }
 
 
-void ClientIrcListHelper::receiveChannelList(const NetworkId &netId, const QStringList &channelFilters, const QVariantList &channels)
+void ClientIrcListHelper::requestNextPage()
+{
+    if (!_paging || _pageRequested)
+        return;
+
+    _pageRequested = true;
+    requestChannelListPage(_netId, _receivedCount);
+}
+
+
+QList<IrcListHelper::ChannelDescription> ClientIrcListHelper::fromVariantList(const QVariantList &channels)
 {
     QVariantList::const_iterator iter = channels.constBegin();
     QVariantList::const_iterator iterEnd = channels.constEnd();
 
     QList<ChannelDescription> channelList;
+    channelList.reserve(channels.count());
     while (iter != iterEnd) {
         QVariantList channelVar = iter->toList();
         ChannelDescription channelDescription(channelVar[0].toString(), channelVar[1].toUInt(), channelVar[2].toString());
         channelList << channelDescription;
         iter++;
     }
+    return channelList;
+}
 
-    emit channelListReceived(netId, channelFilters, channelList);
+
+void ClientIrcListHelper::receiveChannelList(const NetworkId &netId, const QStringList &channelFilters, const QVariantList &channels)
+{
+    if (_paging && netId == _netId && !channels.isEmpty()) {
+        // the core still had a complete list lying around and handed it out instead of issuing a new query
+        _paging = false;
+        _pollTimer.stop();
+        emit channelListReceived(netId, channelFilters, fromVariantList(channels));
+        emit finishedListReported(netId);
+        return;
+    }
+
+    emit channelListReceived(netId, channelFilters, fromVariantList(channels));
+}
+
+
+void ClientIrcListHelper::receiveChannelListPage(const NetworkId &netId, int offset, const QVariantList &channels)
+{
+    if (!_paging || netId != _netId || offset != _receivedCount)
+        return;
+
+    _pageRequested = false;
+    if (!channels.isEmpty()) {
+        _receivedCount += channels.count();
+        emit channelListPageReceived(netId, _channelFilters, fromVariantList(channels));
+        requestNextPage();
+    }
+    else if (_listFinished) {
+        _paging = false;
+        emit finishedListReported(netId);
+    }
+    else {
+        _pollTimer.start();
+    }
 }
 
 
 void ClientIrcListHelper::reportFinishedList(const NetworkId &netId)
 {
-    if (_netId == netId) {
+    if (_netId != netId)
+        return;
+
+    if (_paging) {
+        // fetch whatever is left; finishedListReported() is emitted once we've got everything
+        _listFinished = true;
+        _pollTimer.stop();
+        requestNextPage();
+    }
+    else if (!Client::coreFeatures().testFlag(Quassel::PagedChannelList)) {
         requestChannelList(netId, QStringList());
         emit finishedListReported(netId);
     }
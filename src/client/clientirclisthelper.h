@@ -21,6 +21,8 @@
 #ifndef CLIENTIRCLISTHELPER_H
 #define CLIENTIRCLISTHELPER_H
 
+#include <QTimer>
+
 #include "irclisthelper.h"
 
 class ClientIrcListHelper : public IrcListHelper
@@ -29,23 +31,38 @@ class ClientIrcListHelper : public IrcListHelper
         Q_OBJECT
 
 public:
-    inline ClientIrcListHelper(QObject *object = 0) : IrcListHelper(object) {};
+    ClientIrcListHelper(QObject *object = 0);
 
     inline virtual const QMetaObject *syncMetaObject() const { return &IrcListHelper::staticMetaObject; }
 
 public slots:
     virtual QVariantList requestChannelList(const NetworkId &netId, const QStringList &channelFilters);
     virtual void receiveChannelList(const NetworkId &netId, const QStringList &channelFilters, const QVariantList &channels);
+    virtual void receiveChannelListPage(const NetworkId &netId, int offset, const QVariantList &channels);
     virtual void reportFinishedList(const NetworkId &netId);
     inline virtual void reportError(const QString &error) { emit errorReported(error); }
 
 signals:
     void channelListReceived(const NetworkId &netId, const QStringList &channelFilters, const QList<IrcListHelper::ChannelDescription> &channelList);
+    //! Emitted for each chunk of a paged channel list; the chunks are to be appended to what was received so far
+    void channelListPageReceived(const NetworkId &netId, const QStringList &channelFilters, const QList<IrcListHelper::ChannelDescription> &channelList);
     void finishedListReported(const NetworkId &netId);
     void errorReported(const QString &error);
 
+private slots:
+    void requestNextPage();
+
 private:
+    static QList<ChannelDescription> fromVariantList(const QVariantList &channels);
+
     NetworkId _netId;
+    QStringList _channelFilters;
+
+    bool _paging;
+    bool _pageRequested;
+    bool _listFinished;
+    int _receivedCount;
+    QTimer _pollTimer;
 };
 
 
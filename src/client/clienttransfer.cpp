@@ -19,13 +19,18 @@
  ***************************************************************************/
 
 #include <QFile>
+#include <QTcpSocket>
 
 #include "clienttransfer.h"
 
+#include "client.h"
+
 INIT_SYNCABLE_OBJECT(ClientTransfer)
 ClientTransfer::ClientTransfer(const QUuid &uuid, QObject *parent)
     : Transfer(uuid, parent),
-    _file(0)
+    _file(0),
+    _received(0),
+    _socket(0)
 {
     connect(this, SIGNAL(stateChanged(State)), SLOT(onStateChanged(State)));
 }
@@ -33,6 +38,12 @@ ClientTransfer::ClientTransfer(const QUuid &uuid, QObject *parent)
 
 void ClientTransfer::cleanUp()
 {
+    if (_socket) {
+        _socket->abort();
+        _socket->deleteLater();
+        _socket = 0;
+    }
+
     if (_file) {
         _file->close();
         _file->deleteLater();
@@ -64,24 +75,92 @@ void ClientTransfer::reject() const
 }
 
 
-void ClientTransfer::dataReceived(PeerPtr, const QByteArray &data)
+bool ClientTransfer::writeData(const QByteArray &data)
 {
     // TODO: proper error handling (relay to core)
     if (!_file) {
         _file = new QFile(_savePath, this);
         if (!_file->open(QFile::WriteOnly|QFile::Truncate)) {
             qWarning() << Q_FUNC_INFO << "Could not open file:" << _file->errorString();
-            return;
+            return false;
         }
     }
 
     if (!_file->isOpen())
-        return;
+        return false;
 
     if (_file->write(data) < 0) {
         qWarning() << Q_FUNC_INFO << "Could not write to file:" << _file->errorString();
+        return false;
+    }
+
+    // files stored on the core are only sent once the transfer is already completed
+    _received += data.size();
+    if (state() == Completed && _received >= fileSize())
+        _file->close();
+    return true;
+}
+
+
+void ClientTransfer::dataReceived(PeerPtr, const QByteArray &data)
+{
+    if (!writeData(data))
+        return;
+
+    // let the core know that we can take more
+    if (Client::coreFeatures().testFlag(Quassel::TransferFlowControl)) {
+        PeerPtr ptr = 0;
+        REQUEST_OTHER(dataAcknowledged, ARG(ptr), ARG(_received));
+    }
+}
+
+
+void ClientTransfer::storedFileReady(PeerPtr, quint16 port, const QByteArray &token)
+{
+    if (_socket)
+        return;
+
+    _socket = new QTcpSocket(this);
+    connect(_socket, SIGNAL(readyRead()), SLOT(onStoredDataAvailable()));
+    connect(_socket, SIGNAL(disconnected()), SLOT(onStoredConnectionClosed()));
+    connect(_socket, SIGNAL(error(QAbstractSocket::SocketError)), SLOT(onStoredConnectionClosed()));
+
+    // the core listens where we reached it
+    if (Client::internalCore())
+        _socket->connectToHost(QHostAddress(QHostAddress::LocalHost), port);
+    else
+        _socket->connectToHost(Client::currentCoreAccount().hostName(), port);
+    _socket->write(token);
+}
+
+
+void ClientTransfer::onStoredDataAvailable()
+{
+    if (!_socket)
+        return;
+
+    if (!writeData(_socket->readAll())) {
+        cleanUp();
         return;
     }
+
+    // the core waits for us to close the connection once we have everything
+    if (_received >= fileSize())
+        cleanUp();
+}
+
+
+void ClientTransfer::onStoredConnectionClosed()
+{
+    if (!_socket)
+        return;
+
+    if (_received < fileSize()) {
+        qWarning() << Q_FUNC_INFO << "Connection closed before the file was complete:" << _socket->errorString();
+        if (_file)
+            _file->remove();
+    }
+    cleanUp();
 }
 
 
@@ -26,6 +26,7 @@
 #include "transfer.h"
 
 class QFile;
+class QTcpSocket;
 
 class ClientTransfer : public Transfer
 {
@@ -44,14 +45,21 @@ public slots:
 
 private slots:
     void dataReceived(PeerPtr peer, const QByteArray &data);
+    void storedFileReady(PeerPtr peer, quint16 port, const QByteArray &token);
     void onStateChanged(State state);
 
+    void onStoredDataAvailable();
+    void onStoredConnectionClosed();
+
 private:
     virtual void cleanUp();
+    bool writeData(const QByteArray &data);
 
     mutable QString _savePath;
 
     QFile *_file;
+    quint64 _received;
+    QTcpSocket *_socket; // fetches a file stored on the core
 };
 
 #endif
@@ -59,15 +59,14 @@ void ClientUserInputHandler::handleUserInput(const BufferInfo &bufferInfo, const
     if (msg.isEmpty())
         return;
 
-    if (!msg.startsWith('/')) {
-        if (_nickRx.indexIn(msg) == 0) {
-            const Network *net = Client::network(bufferInfo.networkId());
-            IrcUser *user = net ? net->ircUser(_nickRx.cap(1)) : 0;
-            if (user)
-                user->setLastSpokenTo(bufferInfo.bufferId(), QDateTime::currentDateTime().toUTC());
-        }
+    if (msg.contains('\n')) {
+        handleBulkInput(bufferInfo, msg.split('\n', QString::SkipEmptyParts));
+        return;
     }
 
+    if (!msg.startsWith('/'))
+        updateLastSpokenTo(bufferInfo, msg);
+
     AliasManager::CommandList clist = Client::aliasManager()->processInput(bufferInfo, msg);
 
     for (int i = 0; i < clist.count(); i++) {
@@ -78,6 +77,51 @@ void ClientUserInputHandler::handleUserInput(const BufferInfo &bufferInfo, const
 }
 
 
+void ClientUserInputHandler::handleBulkInput(const BufferInfo &bufferInfo, const QStringList &lines)
+{
+    if (!Client::coreFeatures().testFlag(Quassel::BulkUserInput)) {
+        foreach(const QString &line, lines)
+            handleUserInput(bufferInfo, line);
+        return;
+    }
+
+    // Runs of plain text are sent to the core as a single /SAY, which splits them up again and
+    // queues the lines behind its flood protection. Commands are still handled one by one.
+    QStringList said;
+    foreach(const QString &line, lines) {
+        AliasManager::CommandList clist = Client::aliasManager()->processInput(bufferInfo, line);
+        if (clist.count() == 1 && clist.at(0).second.startsWith("/SAY ")) {
+            if (!line.startsWith('/'))
+                updateLastSpokenTo(bufferInfo, line);
+            said << clist.at(0).second.mid(5);
+            continue;
+        }
+        if (!said.isEmpty()) {
+            emit sendInput(bufferInfo, "/SAY " + said.join("\n"));
+            said.clear();
+        }
+        for (int i = 0; i < clist.count(); i++) {
+            QString cmd = clist.at(i).second.section(' ', 0, 0).remove(0, 1).toUpper();
+            QString payload = clist.at(i).second.section(' ', 1);
+            handle(cmd, Q_ARG(BufferInfo, clist.at(i).first), Q_ARG(QString, payload));
+        }
+    }
+    if (!said.isEmpty())
+        emit sendInput(bufferInfo, "/SAY " + said.join("\n"));
+}
+
+
+void ClientUserInputHandler::updateLastSpokenTo(const BufferInfo &bufferInfo, const QString &msg)
+{
+    if (_nickRx.indexIn(msg) == 0) {
+        const Network *net = Client::network(bufferInfo.networkId());
+        IrcUser *user = net ? net->ircUser(_nickRx.cap(1)) : 0;
+        if (user)
+            user->setLastSpokenTo(bufferInfo.bufferId(), QDateTime::currentDateTime().toUTC());
+    }
+}
+
+
 void ClientUserInputHandler::defaultHandler(const QString &cmd, const BufferInfo &bufferInfo, const QString &text)
 {
     QString command = QString("/%1 %2").arg(cmd, text);
@@ -50,6 +50,10 @@ private slots:
 private:
     QRegExp _nickRx;
 
+    //! Handles a multi-line input, sending runs of plain text lines to the core in one go
+    void handleBulkInput(const BufferInfo &bufferInfo, const QStringList &lines);
+    void updateLastSpokenTo(const BufferInfo &bufferInfo, const QString &msg);
+
     //! Helper method for switching to new/existing buffers
     /** Immediately switches to the given buffer or schedules a switch for whenever
       * the buffer is created
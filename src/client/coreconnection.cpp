@@ -30,6 +30,7 @@
 #include "networkmodel.h"
 #include "quassel.h"
 #include "signalproxy.h"
+#include "startupprofiler.h"
 #include "util.h"
 
 #include "protocols/legacy/legacypeer.h"
@@ -333,7 +334,7 @@ bool CoreConnection::connectToCore(AccountId accId)
     else {
         if (!accId.isValid()) {
             // check our settings and figure out what to do
-            if (!s.autoConnectOnStartup())
+            if (!s.autoConnectOnStartup() && !Quassel::isOptionSet("startup-benchmark"))
                 return false;
             if (s.autoConnectToFixedAccount())
                 accId = s.autoConnectAccount();
@@ -370,6 +371,7 @@ void CoreConnection::connectToCurrentAccount()
             qWarning() << "Cannot connect to internal core in client-only mode!";
             return;
         }
+        StartupProfiler::begin("Core connection handshake");
         emit startInternalCore();
 
         InternalPeer *peer = new InternalPeer();
@@ -406,6 +408,7 @@ void CoreConnection::connectToCurrentAccount()
     connect(_authHandler, SIGNAL(loginSuccessful(CoreAccount)), SLOT(onLoginSuccessful(CoreAccount)));
     connect(_authHandler, SIGNAL(handshakeComplete(RemotePeer*,Protocol::SessionState)), SLOT(onHandshakeComplete(RemotePeer*,Protocol::SessionState)));
 
+    StartupProfiler::begin("Core connection handshake");
     setState(Connecting);
     _authHandler->connectToCore();
 }
@@ -441,6 +444,7 @@ void CoreConnection::onLoginSuccessful(const CoreAccount &account)
 
 void CoreConnection::onHandshakeComplete(RemotePeer *peer, const Protocol::SessionState &sessionState)
 {
+    StartupProfiler::end("Core connection handshake");
     updateProgress(100, 100);
 
     disconnect(_authHandler, 0, this, 0);
@@ -460,6 +464,7 @@ void CoreConnection::onHandshakeComplete(RemotePeer *peer, const Protocol::Sessi
 
 void CoreConnection::internalSessionStateReceived(const Protocol::SessionState &sessionState)
 {
+    StartupProfiler::end("Core connection handshake");
     updateProgress(100, 100);
 
     Client::setCoreFeatures(Quassel::features()); // mono connection...
@@ -471,6 +476,7 @@ void CoreConnection::internalSessionStateReceived(const Protocol::SessionState &
 
 void CoreConnection::syncToCore(const Protocol::SessionState &sessionState)
 {
+    StartupProfiler::begin("SessionState processing");
     setProgressText(tr("Receiving network states"));
     updateProgress(0, 100);
 
@@ -502,6 +508,8 @@ void CoreConnection::syncToCore(const Protocol::SessionState &sessionState)
         connect(net, SIGNAL(destroyed()), SLOT(networkInitDone()));
         Client::addNetwork(net);
     }
+    StartupProfiler::end("SessionState processing");
+    StartupProfiler::begin("Network synchronization");
     checkSyncState();
 }
 
@@ -524,6 +532,7 @@ void CoreConnection::checkSyncState()
         setState(Synchronized);
         setProgressText(tr("Synchronized to %1").arg(currentAccount().accountName()));
         setProgressMaximum(-1);
+        StartupProfiler::end("Network synchronization");
         emit synchronized();
     }
 }
@@ -0,0 +1,79 @@
+/***************************************************************************
+ *   Copyright (C) 2005-2015 by the Quassel Project                        *
+ *   devel@quassel-irc.org                                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3.                                           *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.         *
+ ***************************************************************************/
+
+#include "irclistfilter.h"
+
+#include "irclistmodel.h"
+
+IrcListFilter::IrcListFilter(QObject *parent)
+    : QSortFilterProxyModel(parent),
+    _ircListModel(0)
+{
+    setDynamicSortFilter(true);
+}
+
+
+void IrcListFilter::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    _ircListModel = qobject_cast<IrcListModel *>(sourceModel);
+    QSortFilterProxyModel::setSourceModel(sourceModel);
+}
+
+
+void IrcListFilter::setFilterString(const QString &filterString)
+{
+    QString lowerFilter = filterString.toLower();
+    if (lowerFilter == _filterString)
+        return;
+
+    _filterString = lowerFilter;
+    invalidateFilter();
+}
+
+
+bool IrcListFilter::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+    if (_filterString.isEmpty())
+        return true;
+
+    if (!_ircListModel)
+        return QSortFilterProxyModel::filterAcceptsRow(sourceRow, sourceParent);
+
+    return _ircListModel->matches(sourceRow, _filterString);
+}
+
+
+bool IrcListFilter::lessThan(const QModelIndex &left, const QModelIndex &right) const
+{
+    if (!_ircListModel)
+        return QSortFilterProxyModel::lessThan(left, right);
+
+    const IrcListHelper::ChannelDescription &leftChannel = _ircListModel->channel(left.row());
+    const IrcListHelper::ChannelDescription &rightChannel = _ircListModel->channel(right.row());
+
+    switch (left.column()) {
+    case 1:
+        return leftChannel.userCount < rightChannel.userCount;
+    case 2:
+        return QString::compare(leftChannel.topic, rightChannel.topic, sortCaseSensitivity()) < 0;
+    default:
+        return QString::compare(leftChannel.channelName, rightChannel.channelName, sortCaseSensitivity()) < 0;
+    }
+}
@@ -0,0 +1,54 @@
+/***************************************************************************
+ *   Copyright (C) 2005-2015 by the Quassel Project                        *
+ *   devel@quassel-irc.org                                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3.                                           *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.         *
+ ***************************************************************************/
+
+#ifndef IRCLISTFILTER_H
+#define IRCLISTFILTER_H
+
+#include <QSortFilterProxyModel>
+
+class IrcListModel;
+
+//! Filters and sorts an IrcListModel without going through QVariant for every row
+/** Filtering uses the lower-cased per-row keys kept by IrcListModel, so typing into a filter
+ *  line stays responsive even for lists with tens of thousands of channels.
+ */
+class IrcListFilter : public QSortFilterProxyModel
+{
+    Q_OBJECT
+
+public:
+    IrcListFilter(QObject *parent = 0);
+
+    virtual void setSourceModel(QAbstractItemModel *sourceModel);
+
+public slots:
+    void setFilterString(const QString &filterString);
+
+protected:
+    virtual bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const;
+    virtual bool lessThan(const QModelIndex &left, const QModelIndex &right) const;
+
+private:
+    IrcListModel *_ircListModel;
+    QString _filterString;
+};
+
+
+#endif //IRCLISTFILTER_H
@@ -33,7 +33,7 @@ QVariant IrcListModel::data(const QModelIndex &index, int role) const
     if (!index.isValid() || index.row() >= rowCount() || index.column() >= columnCount() || role != Qt::DisplayRole)
         return QVariant();
 
-    IrcListHelper::ChannelDescription channel = _channelList[index.row()];
+    const IrcListHelper::ChannelDescription &channel = _channelList[index.row()];
 
     switch (index.column()) {
     case 0:
@@ -88,12 +88,31 @@ void IrcListModel::setChannelList(const QList<IrcListHelper::ChannelDescription>
     if (rowCount() > 0) {
         beginRemoveRows(QModelIndex(), 0, _channelList.count() - 1);
         _channelList.clear();
+        _filterKeys.clear();
         endRemoveRows();
     }
 
-    if (channelList.count() > 0) {
-        beginInsertRows(QModelIndex(), 0, channelList.count() - 1);
-        _channelList = channelList;
-        endInsertRows();
-    }
+    appendChannels(channelList);
+}
+
+
+void IrcListModel::appendChannels(const QList<IrcListHelper::ChannelDescription> &channelList)
+{
+    if (channelList.isEmpty())
+        return;
+
+    int start = _channelList.count();
+    beginInsertRows(QModelIndex(), start, start + channelList.count() - 1);
+    _channelList.append(channelList);
+    _filterKeys.reserve(_channelList.count());
+    foreach(const IrcListHelper::ChannelDescription &channel, channelList)
+        _filterKeys << filterKey(channel);
+    endInsertRows();
+}
+
+
+QString IrcListModel::filterKey(const IrcListHelper::ChannelDescription &channel)
+{
+    // fields are separated by a character that can't be typed into the filter line, so matches don't span columns
+    return QString("%1\n%2\n%3").arg(channel.channelName, QString::number(channel.userCount), channel.topic).toLower();
 }
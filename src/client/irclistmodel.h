@@ -24,6 +24,7 @@
 #include "irclisthelper.h"
 
 #include <QAbstractItemModel>
+#include <QStringList>
 
 class IrcListModel : public QAbstractItemModel
 {
@@ -44,11 +45,23 @@ public:
     inline int rowCount(const QModelIndex &parent = QModelIndex()) const { Q_UNUSED(parent) return _channelList.count(); }
     inline int columnCount(const QModelIndex &parent = QModelIndex()) const { Q_UNUSED(parent) return 3; }
 
+    inline const IrcListHelper::ChannelDescription &channel(int row) const { return _channelList.at(row); }
+
+    //! Checks if any column of the given row contains filterString
+    /** \param filterString The string to look for; must already be lower case
+     *  \return true, if the row matches the filter
+     */
+    inline bool matches(int row, const QString &filterString) const { return _filterKeys.at(row).contains(filterString); }
+
 public slots:
     void setChannelList(const QList<IrcListHelper::ChannelDescription> &channelList = QList<IrcListHelper::ChannelDescription>());
+    void appendChannels(const QList<IrcListHelper::ChannelDescription> &channelList);
 
 private:
+    static QString filterKey(const IrcListHelper::ChannelDescription &channel);
+
     QList<IrcListHelper::ChannelDescription> _channelList;
+    QStringList _filterKeys; // lower-cased concatenation of all columns, row by row
 };
 
 
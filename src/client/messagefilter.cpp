@@ -20,6 +20,8 @@
 
 #include "messagefilter.h"
 
+#include <algorithm>
+
 #include "buffersettings.h"
 #include "client.h"
 #include "buffermodel.h"
@@ -28,7 +30,9 @@
 #include "clientignorelistmanager.h"
 
 MessageFilter::MessageFilter(QAbstractItemModel *source, QObject *parent)
-    : QSortFilterProxyModel(parent),
+    : QAbstractProxyModel(parent),
+    _messageModel(0),
+    _rowsValid(false),
     _messageTypeFilter(0)
 {
     init();
@@ -37,7 +41,9 @@ MessageFilter::MessageFilter(QAbstractItemModel *source, QObject *parent)
 
 
 MessageFilter::MessageFilter(MessageModel *source, const QList<BufferId> &buffers, QObject *parent)
-    : QSortFilterProxyModel(parent),
+    : QAbstractProxyModel(parent),
+    _messageModel(0),
+    _rowsValid(false),
     _validBuffers(buffers.toSet()),
     _messageTypeFilter(0)
 {
@@ -48,8 +54,6 @@ MessageFilter::MessageFilter(MessageModel *source, const QList<BufferId> &buffer
 
 void MessageFilter::init()
 {
-    setDynamicSortFilter(true);
-
     _userNoticesTarget = _serverNoticesTarget = _errorMsgsTarget = -1;
 
     BufferSettings defaultSettings;
@@ -69,6 +73,266 @@ void MessageFilter::init()
 }
 
 
+QModelIndex MessageFilter::index(int row, int column, const QModelIndex &parent) const
+{
+    if (parent.isValid() || row < 0 || row >= rowCount() || column < 0 || column >= columnCount())
+        return QModelIndex();
+
+    return createIndex(row, column);
+}
+
+
+int MessageFilter::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+
+    ensureRows();
+    return _sourceRows.count();
+}
+
+
+int MessageFilter::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent)
+    return sourceModel() ? sourceModel()->columnCount() : 0;
+}
+
+
+QModelIndex MessageFilter::mapToSource(const QModelIndex &proxyIndex) const
+{
+    if (!proxyIndex.isValid() || !sourceModel())
+        return QModelIndex();
+
+    ensureRows();
+    if (proxyIndex.row() >= _sourceRows.count())
+        return QModelIndex();
+
+    return sourceModel()->index(_sourceRows.at(proxyIndex.row()), proxyIndex.column());
+}
+
+
+QModelIndex MessageFilter::mapFromSource(const QModelIndex &sourceIndex) const
+{
+    if (!sourceIndex.isValid())
+        return QModelIndex();
+
+    ensureRows();
+    QVector<int>::const_iterator it = std::lower_bound(_sourceRows.constBegin(), _sourceRows.constEnd(), sourceIndex.row());
+    if (it == _sourceRows.constEnd() || *it != sourceIndex.row())
+        return QModelIndex();
+
+    return index(it - _sourceRows.constBegin(), sourceIndex.column());
+}
+
+
+void MessageFilter::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    beginResetModel();
+
+    if (QAbstractProxyModel::sourceModel()) {
+        QAbstractItemModel *oldModel = QAbstractProxyModel::sourceModel();
+        disconnect(oldModel, SIGNAL(rowsInserted(QModelIndex, int, int)), this, SLOT(sourceRowsInserted(QModelIndex, int, int)));
+        disconnect(oldModel, SIGNAL(rowsAboutToBeRemoved(QModelIndex, int, int)), this, SLOT(sourceRowsAboutToBeRemoved(QModelIndex, int, int)));
+        disconnect(oldModel, SIGNAL(rowsRemoved(QModelIndex, int, int)), this, SLOT(sourceRowsRemoved(QModelIndex, int, int)));
+        disconnect(oldModel, SIGNAL(dataChanged(QModelIndex, QModelIndex)), this, SLOT(sourceDataChanged(QModelIndex, QModelIndex)));
+        disconnect(oldModel, SIGNAL(modelReset()), this, SLOT(sourceModelReset()));
+    }
+
+    QAbstractProxyModel::setSourceModel(sourceModel);
+    _messageModel = qobject_cast<MessageModel *>(sourceModel);
+    _sourceRows.clear();
+    _rowsValid = false;
+
+    if (sourceModel) {
+        connect(sourceModel, SIGNAL(rowsInserted(QModelIndex, int, int)), SLOT(sourceRowsInserted(QModelIndex, int, int)));
+        connect(sourceModel, SIGNAL(rowsAboutToBeRemoved(QModelIndex, int, int)), SLOT(sourceRowsAboutToBeRemoved(QModelIndex, int, int)));
+        connect(sourceModel, SIGNAL(rowsRemoved(QModelIndex, int, int)), SLOT(sourceRowsRemoved(QModelIndex, int, int)));
+        connect(sourceModel, SIGNAL(dataChanged(QModelIndex, QModelIndex)), SLOT(sourceDataChanged(QModelIndex, QModelIndex)));
+        connect(sourceModel, SIGNAL(modelReset()), SLOT(sourceModelReset()));
+    }
+
+    endResetModel();
+}
+
+
+void MessageFilter::ensureRows() const
+{
+    if (_rowsValid || !sourceModel())
+        return;
+
+    _sourceRows = acceptedRows(0, sourceModel()->rowCount() - 1);
+    _rowsValid = true;
+}
+
+
+QVector<int> MessageFilter::candidateRows(int first, int last) const
+{
+    QVector<int> rows;
+    if (first > last)
+        return rows;
+
+    if (!_messageModel || _validBuffers.isEmpty()) {
+        rows.reserve(last - first + 1);
+        for (int row = first; row <= last; row++)
+            rows << row;
+        return rows;
+    }
+
+    // besides our own buffers, messages without a buffer and those that may be shown
+    // outside of their buffer (quits in queries, redirections) need a closer look
+    QList<QVector<int> > partitions;
+    foreach(BufferId bufferId, _validBuffers)
+        partitions << _messageModel->bufferRows(bufferId);
+    partitions << _messageModel->bufferRows(BufferId()) << _messageModel->foreignRows();
+
+    foreach(const QVector<int> &partition, partitions) {
+        QVector<int>::const_iterator begin = std::lower_bound(partition.constBegin(), partition.constEnd(), first);
+        QVector<int>::const_iterator end = std::upper_bound(begin, partition.constEnd(), last);
+        for (; begin != end; ++begin)
+            rows << *begin;
+    }
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    return rows;
+}
+
+
+QVector<int> MessageFilter::acceptedRows(int first, int last) const
+{
+    QVector<int> rows;
+    foreach(int row, candidateRows(first, last)) {
+        if (filterAcceptsRow(row, QModelIndex()))
+            rows << row;
+    }
+    return rows;
+}
+
+
+void MessageFilter::updateRows(int first, int last)
+{
+    QVector<int> accepted = acceptedRows(first, last);
+
+    // drop the rows that aren't accepted anymore, back to front so positions stay valid
+    int lo = std::lower_bound(_sourceRows.constBegin(), _sourceRows.constEnd(), first) - _sourceRows.constBegin();
+    int pos = std::upper_bound(_sourceRows.constBegin(), _sourceRows.constEnd(), last) - _sourceRows.constBegin();
+    while (pos > lo) {
+        if (std::binary_search(accepted.constBegin(), accepted.constEnd(), _sourceRows.at(pos - 1))) {
+            pos--;
+            continue;
+        }
+        int end = pos;
+        while (pos > lo && !std::binary_search(accepted.constBegin(), accepted.constEnd(), _sourceRows.at(pos - 1)))
+            pos--;
+        beginRemoveRows(QModelIndex(), pos, end - 1);
+        _sourceRows.remove(pos, end - pos);
+        endRemoveRows();
+    }
+
+    // what's left is a subset of the accepted rows, so the missing ones go in as contiguous runs
+    pos = lo;
+    int i = 0;
+    while (i < accepted.count()) {
+        if (pos < _sourceRows.count() && _sourceRows.at(pos) == accepted.at(i)) {
+            pos++;
+            i++;
+            continue;
+        }
+        int runStart = i;
+        while (i < accepted.count() && (pos == _sourceRows.count() || accepted.at(i) < _sourceRows.at(pos)))
+            i++;
+        beginInsertRows(QModelIndex(), pos, pos + i - runStart - 1);
+        _sourceRows.insert(pos, i - runStart, 0);
+        std::copy(accepted.constBegin() + runStart, accepted.constBegin() + i, _sourceRows.begin() + pos);
+        endInsertRows();
+        pos += i - runStart;
+    }
+}
+
+
+void MessageFilter::invalidateFilter()
+{
+    if (!_rowsValid || !sourceModel())
+        return;
+
+    updateRows(0, sourceModel()->rowCount() - 1);
+}
+
+
+void MessageFilter::sourceRowsInserted(const QModelIndex &parent, int start, int end)
+{
+    if (parent.isValid() || !_rowsValid)
+        return;
+
+    int count = end - start + 1;
+    QVector<int>::iterator it = std::lower_bound(_sourceRows.begin(), _sourceRows.end(), start);
+    int pos = it - _sourceRows.begin();
+    for (; it != _sourceRows.end(); ++it)
+        *it += count;
+
+    QVector<int> rows = acceptedRows(start, end);
+    if (rows.isEmpty())
+        return;
+
+    beginInsertRows(QModelIndex(), pos, pos + rows.count() - 1);
+    _sourceRows.insert(pos, rows.count(), 0);
+    std::copy(rows.constBegin(), rows.constEnd(), _sourceRows.begin() + pos);
+    endInsertRows();
+}
+
+
+void MessageFilter::sourceRowsAboutToBeRemoved(const QModelIndex &parent, int start, int end)
+{
+    if (parent.isValid() || !_rowsValid)
+        return;
+
+    int first = std::lower_bound(_sourceRows.constBegin(), _sourceRows.constEnd(), start) - _sourceRows.constBegin();
+    int last = std::upper_bound(_sourceRows.constBegin(), _sourceRows.constEnd(), end) - _sourceRows.constBegin();
+    if (first == last)
+        return;
+
+    beginRemoveRows(QModelIndex(), first, last - 1);
+    _sourceRows.remove(first, last - first);
+    endRemoveRows();
+}
+
+
+void MessageFilter::sourceRowsRemoved(const QModelIndex &parent, int start, int end)
+{
+    if (parent.isValid() || !_rowsValid)
+        return;
+
+    int count = end - start + 1;
+    QVector<int>::iterator it = std::lower_bound(_sourceRows.begin(), _sourceRows.end(), start);
+    for (; it != _sourceRows.end(); ++it)
+        *it -= count;
+}
+
+
+void MessageFilter::sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    if (!_rowsValid || !topLeft.isValid() || !bottomRight.isValid())
+        return;
+
+    // the change may affect whether we accept a message (e.g. when buffers have been merged)
+    updateRows(topLeft.row(), bottomRight.row());
+
+    int first = std::lower_bound(_sourceRows.constBegin(), _sourceRows.constEnd(), topLeft.row()) - _sourceRows.constBegin();
+    int last = std::upper_bound(_sourceRows.constBegin(), _sourceRows.constEnd(), bottomRight.row()) - _sourceRows.constBegin();
+    if (first < last)
+        emit dataChanged(index(first, topLeft.column()), index(last - 1, bottomRight.column()));
+}
+
+
+void MessageFilter::sourceModelReset()
+{
+    beginResetModel();
+    _sourceRows.clear();
+    _rowsValid = false;
+    endResetModel();
+}
+
+
 void MessageFilter::messageTypeFilterChanged()
 {
     int newFilter;
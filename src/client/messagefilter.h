@@ -21,7 +21,8 @@
 #ifndef MESSAGEFILTER_H_
 #define MESSAGEFILTER_H_
 
-#include <QSortFilterProxyModel>
+#include <QAbstractProxyModel>
+#include <QVector>
 
 #include "bufferinfo.h"
 #include "client.h"
@@ -29,7 +30,11 @@
 #include "networkmodel.h"
 #include "types.h"
 
-class MessageFilter : public QSortFilterProxyModel
+//! Shows the messages of a set of buffers (or all of them) from a MessageModel
+/** Filters for specific buffers only look at the rows the MessageModel keeps for those buffers,
+ *  so creating a filter or inserting messages doesn't get more expensive with the number of buffers.
+ */
+class MessageFilter : public QAbstractProxyModel
 {
     Q_OBJECT
 
@@ -39,6 +44,15 @@ protected:
 public:
     MessageFilter(MessageModel *, const QList<BufferId> &buffers = QList<BufferId>(), QObject *parent = 0);
 
+    virtual QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const;
+    inline virtual QModelIndex parent(const QModelIndex &) const { return QModelIndex(); }
+    virtual int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    virtual int columnCount(const QModelIndex &parent = QModelIndex()) const;
+
+    virtual QModelIndex mapToSource(const QModelIndex &proxyIndex) const;
+    virtual QModelIndex mapFromSource(const QModelIndex &sourceIndex) const;
+    virtual void setSourceModel(QAbstractItemModel *sourceModel);
+
     virtual bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const;
     virtual QString idString() const;
     inline bool isSingleBufferFilter() const { return _validBuffers.count() == 1; }
@@ -50,17 +64,35 @@ public slots:
     void messageTypeFilterChanged();
     void messageRedirectionChanged();
     void requestBacklog();
-    // redefined as public slot
-    void invalidateFilter() { QSortFilterProxyModel::invalidateFilter(); }
+    void invalidateFilter();
 
 protected:
     QString bufferName() const { return Client::networkModel()->bufferName(singleBufferId()); }
     BufferInfo::Type bufferType() const { return Client::networkModel()->bufferType(singleBufferId()); }
     NetworkId networkId() const { return Client::networkModel()->networkId(singleBufferId()); }
 
+private slots:
+    void sourceRowsInserted(const QModelIndex &parent, int start, int end);
+    void sourceRowsAboutToBeRemoved(const QModelIndex &parent, int start, int end);
+    void sourceRowsRemoved(const QModelIndex &parent, int start, int end);
+    void sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void sourceModelReset();
+
 private:
     void init();
 
+    //! Fills the row mapping on first use, when subclasses are fully constructed
+    void ensureRows() const;
+    //! Returns the source rows between first and last that may be accepted, in ascending order
+    QVector<int> candidateRows(int first, int last) const;
+    QVector<int> acceptedRows(int first, int last) const;
+    //! Brings the mapping of the source rows between first and last up to date
+    void updateRows(int first, int last);
+
+    MessageModel *_messageModel;
+    mutable QVector<int> _sourceRows; // accepted source rows, in ascending order
+    mutable bool _rowsValid;
+
     QSet<BufferId> _validBuffers;
     QMultiHash<QString, uint> _filteredQuitMsgs;
     int _messageTypeFilter;
@@ -20,7 +20,11 @@
 
 #include "messagemodel.h"
 
+#include <algorithm>
+
 #include <QEvent>
+#include <QPair>
+#include <QVector>
 
 #include "backlogsettings.h"
 #include "clientbacklogmanager.h"
@@ -35,17 +39,149 @@ public:
 };
 
 
+// Splits a message list into its runs of ascending or descending msgIds, each returned in ascending order.
+// Backlog arrives grouped by buffer and ordered by msgId, so there's usually just one run per buffer.
+static QList<QList<Message> > ascendingRuns(const QList<Message> &msglist)
+{
+    QList<QList<Message> > runs;
+    int start = 0;
+    while (start < msglist.count()) {
+        int end = start + 1;
+        if (end < msglist.count() && msglist.at(end).msgId() < msglist.at(start).msgId()) {
+            while (end < msglist.count() && msglist.at(end).msgId() < msglist.at(end - 1).msgId())
+                end++;
+            QList<Message> run;
+            run.reserve(end - start);
+            for (int i = end - 1; i >= start; i--)
+                run << msglist.at(i);
+            runs << run;
+        }
+        else {
+            while (end < msglist.count() && !(msglist.at(end).msgId() < msglist.at(end - 1).msgId()))
+                end++;
+            runs << msglist.mid(start, end - start);
+        }
+        start = end;
+    }
+    return runs;
+}
+
+
+// Merges runs of ascending msgIds into a single ascending list
+static QList<Message> mergeRuns(const QList<QList<Message> > &runs)
+{
+    if (runs.count() == 1)
+        return runs.first();
+
+    int total = 0;
+    foreach(const QList<Message> &run, runs)
+        total += run.count();
+
+    // heap of (run, position) pairs with the lowest pending msgId on top
+    typedef QPair<int, int> RunHead;
+    QVector<RunHead> heads;
+    for (int i = 0; i < runs.count(); i++) {
+        if (!runs.at(i).isEmpty())
+            heads << RunHead(i, 0);
+    }
+    auto laterHead = [&runs](const RunHead &a, const RunHead &b) {
+        return runs.at(b.first).at(b.second) < runs.at(a.first).at(a.second);
+    };
+    std::make_heap(heads.begin(), heads.end(), laterHead);
+
+    QList<Message> merged;
+    merged.reserve(total);
+    while (!heads.isEmpty()) {
+        std::pop_heap(heads.begin(), heads.end(), laterHead);
+        RunHead &head = heads.last();
+        merged << runs.at(head.first).at(head.second);
+        if (++head.second < runs.at(head.first).count())
+            std::push_heap(heads.begin(), heads.end(), laterHead);
+        else
+            heads.removeLast();
+    }
+    return merged;
+}
+
+
+// Row partitions are kept in ascending order. These adjust them as rows are inserted into or removed
+// from the model.
+static void shiftPartitionRows(QVector<int> &rows, int from, int offset)
+{
+    QVector<int>::iterator it = std::lower_bound(rows.begin(), rows.end(), from);
+    for (; it != rows.end(); ++it)
+        *it += offset;
+}
+
+
+static void insertPartitionRows(QVector<int> &rows, const QVector<int> &newRows)
+{
+    if (newRows.isEmpty())
+        return;
+
+    int pos = std::lower_bound(rows.constBegin(), rows.constEnd(), newRows.first()) - rows.constBegin();
+    rows.insert(pos, newRows.count(), 0);
+    std::copy(newRows.constBegin(), newRows.constEnd(), rows.begin() + pos);
+}
+
+
+static void removePartitionRows(QVector<int> &rows, int start, int end)
+{
+    QVector<int>::iterator first = std::lower_bound(rows.begin(), rows.end(), start);
+    QVector<int>::iterator last = std::upper_bound(first, rows.end(), end);
+    for (QVector<int>::iterator it = last; it != rows.end(); ++it)
+        *it -= end - start + 1;
+    rows.erase(first, last);
+}
+
+
+// The local day a timestamp falls on, as the msecs of its first and of the next day's first moment
+struct LocalDay {
+    qint64 start;
+    qint64 end;
+};
+
+
+// Neighbouring messages are almost always on the same day, so remember the last one to avoid the
+// comparatively expensive conversion to local time. Only used from the GUI thread.
+static LocalDay localDay(qint64 msecs)
+{
+    static LocalDay day = { 0, 0 };
+    if (msecs < day.start || msecs >= day.end) {
+        QDate date = QDateTime::fromMSecsSinceEpoch(msecs).date();
+        day.start = QDateTime(date).toMSecsSinceEpoch();
+        day.end = QDateTime(date.addDays(1)).toMSecsSinceEpoch();
+    }
+    return day;
+}
+
+
+// Returns the day change message to put between two messages, or an invalid message if they are on the same day
+static Message dayChangeBetween(qint64 prevMsecs, qint64 nextMsecs, MsgId prevMsgId)
+{
+    qint64 nextDay = localDay(nextMsecs).start;
+    if (localDay(prevMsecs).start == nextDay)
+        return Message();
+
+    Message dayChangeMsg = Message::ChangeOfDay(QDateTime::fromMSecsSinceEpoch(nextDay));
+    dayChangeMsg.setMsgId(prevMsgId);
+    return dayChangeMsg;
+}
+
+
 MessageModel::MessageModel(QObject *parent)
     : QAbstractItemModel(parent)
 {
-    QDateTime now = QDateTime::currentDateTime();
-    now.setTimeSpec(Qt::UTC);
-    _nextDayChange.setTimeSpec(Qt::UTC);
-    _nextDayChange.setTime_t(((now.toTime_t() / 86400) + 1) * 86400);
-    _nextDayChange.setTimeSpec(Qt::LocalTime);
-    _dayChangeTimer.setInterval(QDateTime::currentDateTime().secsTo(_nextDayChange) * 1000);
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    _nextDayChange = localDay(now).end;
+    _dayChangeTimer.setSingleShot(true);
+    _dayChangeTimer.setInterval((int)(_nextDayChange - now));
     _dayChangeTimer.start();
     connect(&_dayChangeTimer, SIGNAL(timeout()), this, SLOT(changeOfDay()));
+
+    // connected first, so the partitions are up to date by the time filters hear about the change
+    connect(this, SIGNAL(rowsInserted(QModelIndex, int, int)), SLOT(partitionRowsInserted(QModelIndex, int, int)));
+    connect(this, SIGNAL(rowsRemoved(QModelIndex, int, int)), SLOT(partitionRowsRemoved(QModelIndex, int, int)));
 }
 
 
@@ -70,7 +206,9 @@ bool MessageModel::setData(const QModelIndex &index, const QVariant &value, int
         return false;
 
     if (messageItemAt(row)->setData(index.column(), value, role)) {
-        emit dataChanged(index, index);
+        // the redirection target is only of interest to the filters, which set it while filtering
+        if (role != RedirectedToRole)
+            emit dataChanged(index, index);
         return true;
     }
     return false;
@@ -96,24 +234,23 @@ void MessageModel::insertMessages(const QList<Message> &msglist)
     if (msglist.isEmpty())
         return;
 
+    // merging the (already ordered) runs of the new messages with the equally ordered buffer
+    // is a lot cheaper than sorting everything over again
+    QList<QList<Message> > runs = ascendingRuns(msglist);
+
     if (_messageBuffer.isEmpty()) {
-        int processedMsgs = insertMessagesGracefully(msglist);
-        int remainingMsgs = msglist.count() - processedMsgs;
+        QList<Message> sortedList = mergeRuns(runs);
+        int processedMsgs = insertMessagesGracefully(sortedList);
+        int remainingMsgs = sortedList.count() - processedMsgs;
         if (remainingMsgs > 0) {
-            if (msglist.first().msgId() < msglist.last().msgId()) {
-                // in Order - we have just successfully processed "processedMsg" messages from the end of the list
-                _messageBuffer = msglist.mid(0, remainingMsgs);
-            }
-            else {
-                _messageBuffer = msglist.mid(processedMsgs);
-            }
-            qSort(_messageBuffer);
+            // we have just successfully processed "processedMsg" messages from the end of the list
+            _messageBuffer = sortedList.mid(0, remainingMsgs);
             QCoreApplication::postEvent(this, new ProcessBufferEvent());
         }
     }
     else {
-        _messageBuffer << msglist;
-        qSort(_messageBuffer);
+        runs.prepend(_messageBuffer);
+        _messageBuffer = mergeRuns(runs);
     }
 }
 
@@ -132,10 +269,10 @@ void MessageModel::insertMessageGroup(const QList<Message> &msglist)
         // we have to drop or relocate it at the end of this chunk
         int prevIdx = start - 1;
         if (messageItemAt(prevIdx)->msgType() == Message::DayChange
-            && messageItemAt(prevIdx)->timestamp() > msglist.at(0).timestamp()) {
+            && messageItemAt(prevIdx)->timestampMsecs() > msglist.at(0).timestampMsecs()) {
             beginRemoveRows(QModelIndex(), prevIdx, prevIdx);
             Message oldDayChangeMsg = takeMessageAt(prevIdx);
-            if (msglist.last().timestamp() < oldDayChangeMsg.timestamp()) {
+            if (msglist.last().timestampMsecs() < oldDayChangeMsg.timestampMsecs()) {
                 // we have to reinsert it with a changed msgId
                 dayChangeMsg = oldDayChangeMsg;
                 dayChangeMsg.setMsgId(msglist.last().msgId());
@@ -154,18 +291,7 @@ void MessageModel::insertMessageGroup(const QList<Message> &msglist)
         // if this assert triggers then indexForId() would have found a spot right before a DayChangeMsg
         // this should never happen as daychange messages share the msgId with the preceeding message
         Q_ASSERT(messageItemAt(start)->msgType() != Message::DayChange);
-        QDateTime nextTs = messageItemAt(start)->timestamp();
-        QDateTime prevTs = msglist.last().timestamp();
-        nextTs.setTimeSpec(Qt::UTC);
-        prevTs.setTimeSpec(Qt::UTC);
-        uint nextDay = nextTs.toTime_t() / 86400;
-        uint prevDay = prevTs.toTime_t() / 86400;
-        if (nextDay != prevDay) {
-            nextTs.setTime_t(nextDay * 86400);
-            nextTs.setTimeSpec(Qt::LocalTime);
-            dayChangeMsg = Message::ChangeOfDay(nextTs);
-            dayChangeMsg.setMsgId(msglist.last().msgId());
-        }
+        dayChangeMsg = dayChangeBetween(msglist.last().timestampMsecs(), messageItemAt(start)->timestampMsecs(), msglist.last().msgId());
     }
 
     if (dayChangeMsg.isValid())
@@ -246,19 +372,9 @@ int MessageModel::insertMessagesGracefully(const QList<Message> &msglist)
             }
             if ((*iter).msgId() != dupeId) {
                 if (!grouplist.isEmpty()) {
-                    QDateTime nextTs = grouplist.value(0).timestamp();
-                    QDateTime prevTs = (*iter).timestamp();
-                    nextTs.setTimeSpec(Qt::UTC);
-                    prevTs.setTimeSpec(Qt::UTC);
-                    uint nextDay = nextTs.toTime_t() / 86400;
-                    uint prevDay = prevTs.toTime_t() / 86400;
-                    if (nextDay != prevDay) {
-                        nextTs.setTime_t(nextDay * 86400);
-                        nextTs.setTimeSpec(Qt::LocalTime);
-                        Message dayChangeMsg = Message::ChangeOfDay(nextTs);
-                        dayChangeMsg.setMsgId((*iter).msgId());
+                    Message dayChangeMsg = dayChangeBetween((*iter).timestampMsecs(), grouplist.at(0).timestampMsecs(), (*iter).msgId());
+                    if (dayChangeMsg.isValid())
                         grouplist.prepend(dayChangeMsg);
-                    }
                 }
                 dupeId = (*iter).msgId();
                 grouplist.prepend(*iter);
@@ -278,19 +394,9 @@ int MessageModel::insertMessagesGracefully(const QList<Message> &msglist)
             }
             if ((*iter).msgId() != dupeId) {
                 if (!grouplist.isEmpty()) {
-                    QDateTime nextTs = grouplist.value(0).timestamp();
-                    QDateTime prevTs = (*iter).timestamp();
-                    nextTs.setTimeSpec(Qt::UTC);
-                    prevTs.setTimeSpec(Qt::UTC);
-                    uint nextDay = nextTs.toTime_t() / 86400;
-                    uint prevDay = prevTs.toTime_t() / 86400;
-                    if (nextDay != prevDay) {
-                        nextTs.setTime_t(nextDay * 86400);
-                        nextTs.setTimeSpec(Qt::LocalTime);
-                        Message dayChangeMsg = Message::ChangeOfDay(nextTs);
-                        dayChangeMsg.setMsgId((*iter).msgId());
+                    Message dayChangeMsg = dayChangeBetween((*iter).timestampMsecs(), grouplist.at(0).timestampMsecs(), (*iter).msgId());
+                    if (dayChangeMsg.isValid())
                         grouplist.prepend(dayChangeMsg);
-                    }
                 }
                 dupeId = (*iter).msgId();
                 grouplist.prepend(*iter);
@@ -360,19 +466,30 @@ int MessageModel::indexForId(MsgId id)
 
 void MessageModel::changeOfDay()
 {
-    _dayChangeTimer.setInterval(86400000);
-    if (!messagesIsEmpty()) {
-        int idx = messageCount();
-        while (idx > 0 && messageItemAt(idx - 1)->timestamp() > _nextDayChange) {
-            idx--;
-        }
-        beginInsertRows(QModelIndex(), idx, idx);
-        Message dayChangeMsg = Message::ChangeOfDay(_nextDayChange);
-        dayChangeMsg.setMsgId(messageItemAt(idx - 1)->msgId());
-        insertMessage__(idx, dayChangeMsg);
+    // messages are ordered by msgId, which is close enough to timestamp order to search the first one of the new day
+    int start = 0;
+    int end = messageCount();
+    while (start < end) {
+        int pivot = (start + end) / 2;
+        if (messageItemAt(pivot)->timestampMsecs() > _nextDayChange)
+            end = pivot;
+        else
+            start = pivot + 1;
+    }
+
+    if (start > 0) {
+        beginInsertRows(QModelIndex(), start, start);
+        Message dayChangeMsg = Message::ChangeOfDay(QDateTime::fromMSecsSinceEpoch(_nextDayChange));
+        dayChangeMsg.setMsgId(messageItemAt(start - 1)->msgId());
+        insertMessage__(start, dayChangeMsg);
         endInsertRows();
     }
-    _nextDayChange = _nextDayChange.addSecs(86400);
+
+    // the next day isn't necessarily 24 hours away, think DST
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    _nextDayChange = localDay(qMax(now, _nextDayChange)).end;
+    _dayChangeTimer.setInterval((int)(_nextDayChange - now));
+    _dayChangeTimer.start();
 }
 
 
@@ -398,17 +515,16 @@ void MessageModel::requestBacklog(BufferId bufferId)
     BacklogSettings backlogSettings;
     int requestCount = backlogSettings.dynamicBacklogAmount();
 
-    for (int i = 0; i < messageCount(); i++) {
-        if (messageItemAt(i)->bufferId() == bufferId) {
-            _messagesWaiting[bufferId] = requestCount;
-            Client::backlogManager()->emitMessagesRequested(tr("Requesting %1 messages from backlog for buffer %2:%3")
-                .arg(requestCount)
-                .arg(Client::networkModel()->networkName(bufferId))
-                .arg(Client::networkModel()->bufferName(bufferId)));
-            Client::backlogManager()->requestBacklog(bufferId, -1, messageItemAt(i)->msgId(), requestCount);
-            return;
-        }
-    }
+    QVector<int> rows = _bufferRows.value(bufferId);
+    if (rows.isEmpty())
+        return;
+
+    _messagesWaiting[bufferId] = requestCount;
+    Client::backlogManager()->emitMessagesRequested(tr("Requesting %1 messages from backlog for buffer %2:%3")
+        .arg(requestCount)
+        .arg(Client::networkModel()->networkName(bufferId))
+        .arg(Client::networkModel()->bufferName(bufferId)));
+    Client::backlogManager()->requestBacklog(bufferId, -1, messageItemAt(rows.first())->msgId(), requestCount);
 }
 
 
@@ -427,13 +543,61 @@ void MessageModel::messagesReceived(BufferId bufferId, int count)
 
 void MessageModel::buffersPermanentlyMerged(BufferId bufferId1, BufferId bufferId2)
 {
-    for (int i = 0; i < messageCount(); i++) {
-        if (messageItemAt(i)->bufferId() == bufferId2) {
-            messageItemAt(i)->setBufferId(bufferId1);
-            QModelIndex idx = index(i, 0);
-            emit dataChanged(idx, idx);
-        }
+    if (!_bufferRows.contains(bufferId2))
+        return;
+
+    // merge the partitions first, so filters already see the new layout when they get dataChanged()
+    QVector<int> rows2 = _bufferRows.take(bufferId2);
+    QVector<int> &rows1 = _bufferRows[bufferId1];
+    QVector<int> merged(rows1.count() + rows2.count());
+    std::merge(rows1.constBegin(), rows1.constEnd(), rows2.constBegin(), rows2.constEnd(), merged.begin());
+    rows1 = merged;
+
+    foreach(int row, rows2) {
+        messageItemAt(row)->setBufferId(bufferId1);
+        QModelIndex idx = index(row, 0);
+        emit dataChanged(idx, idx);
+    }
+}
+
+
+void MessageModel::partitionRowsInserted(const QModelIndex &parent, int start, int end)
+{
+    Q_UNUSED(parent)
+
+    int count = end - start + 1;
+    QHash<BufferId, QVector<int> >::iterator partition;
+    for (partition = _bufferRows.begin(); partition != _bufferRows.end(); ++partition)
+        shiftPartitionRows(partition.value(), start, count);
+    shiftPartitionRows(_foreignRows, start, count);
+
+    // nothing else lies in between the new rows, so each partition takes them in one go
+    QHash<BufferId, QVector<int> > newRows;
+    QVector<int> newForeignRows;
+    for (int row = start; row <= end; row++) {
+        const MessageModelItem *item = messageItemAt(row);
+        newRows[item->bufferId()] << row;
+        if (item->msgType() == Message::Quit || item->msgFlags() & Message::Redirected)
+            newForeignRows << row;
+    }
+    for (partition = newRows.begin(); partition != newRows.end(); ++partition)
+        insertPartitionRows(_bufferRows[partition.key()], partition.value());
+    insertPartitionRows(_foreignRows, newForeignRows);
+}
+
+
+void MessageModel::partitionRowsRemoved(const QModelIndex &parent, int start, int end)
+{
+    Q_UNUSED(parent)
+
+    QMutableHashIterator<BufferId, QVector<int> > partition(_bufferRows);
+    while (partition.hasNext()) {
+        partition.next();
+        removePartitionRows(partition.value(), start, end);
+        if (partition.value().isEmpty())
+            partition.remove();
     }
+    removePartitionRows(_foreignRows, start, end);
 }
 
 
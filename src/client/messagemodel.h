@@ -24,6 +24,7 @@
 #include <QAbstractItemModel>
 #include <QDateTime>
 #include <QTimer>
+#include <QVector>
 
 #include "message.h"
 #include "types.h"
@@ -73,6 +74,15 @@ public:
 
     void clear();
 
+    //! Returns the rows of the messages in the given buffer, in ascending order
+    /** Messages that don't belong to a buffer, like day changes, are kept under an invalid BufferId.
+     *  Filters use this to only look at the buffers they show.
+     */
+    inline QVector<int> bufferRows(BufferId bufferId) const { return _bufferRows.value(bufferId); }
+
+    //! Returns the rows of quit and redirected messages, which may be shown outside their own buffer
+    inline QVector<int> foreignRows() const { return _foreignRows; }
+
 signals:
     void finishedBacklogFetch(BufferId bufferId);
 
@@ -103,6 +113,8 @@ protected:
 
 private slots:
     void changeOfDay();
+    void partitionRowsInserted(const QModelIndex &parent, int start, int end);
+    void partitionRowsRemoved(const QModelIndex &parent, int start, int end);
 
 private:
     void insertMessageGroup(const QList<Message> &);
@@ -112,8 +124,11 @@ private:
     //  QList<MessageModelItem *> _messageList;
     QList<Message> _messageBuffer;
     QTimer _dayChangeTimer;
-    QDateTime _nextDayChange;
+    qint64 _nextDayChange; // msecs since epoch
     QHash<BufferId, int> _messagesWaiting;
+
+    QHash<BufferId, QVector<int> > _bufferRows;
+    QVector<int> _foreignRows;
 };
 
 
@@ -145,7 +160,8 @@ public:
     virtual bool setData(int column, const QVariant &value, int role);
 
     virtual const Message &message() const = 0;
-    virtual const QDateTime &timestamp() const = 0;
+    virtual QDateTime timestamp() const = 0;
+    virtual qint64 timestampMsecs() const = 0;
     virtual const MsgId &msgId() const = 0;
     virtual const BufferId &bufferId() const = 0;
     virtual void setBufferId(BufferId bufferId) = 0;
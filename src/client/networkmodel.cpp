@@ -644,6 +644,8 @@ void ChannelBufferItem::attachIrcChannel(IrcChannel *ircChannel)
         this, SLOT(userModeChanged(IrcUser *)));
     connect(ircChannel, SIGNAL(ircUserModeRemoved(IrcUser *, QString)),
         this, SLOT(userModeChanged(IrcUser *)));
+    connect(ircChannel, SIGNAL(ircUserModesChanged(QList<IrcUser *> )),
+        this, SLOT(userModesChanged(QList<IrcUser *> )));
 
     if (!ircChannel->ircUsers().isEmpty())
         join(ircChannel->ircUsers());
@@ -799,6 +801,26 @@ void ChannelBufferItem::userModeChanged(IrcUser *ircUser)
 }
 
 
+void ChannelBufferItem::userModesChanged(const QList<IrcUser *> &ircUsers)
+{
+    Q_ASSERT(_ircChannel);
+
+    // take everyone out of their old category first, so each new category gets its users in one insert
+    QList<IrcUser *> movedUsers;
+    foreach(IrcUser *ircUser, ircUsers) {
+        UserCategoryItem *categoryItem = findCategoryItem(UserCategoryItem::categoryFromModes(_ircChannel->userModes(ircUser)));
+        if (categoryItem && categoryItem->findIrcUser(ircUser))
+            continue; // already in the right category
+
+        removeUserFromCategory(ircUser);
+        movedUsers << ircUser;
+    }
+
+    if (!movedUsers.isEmpty())
+        addUsersToCategory(movedUsers);
+}
+
+
 /*****************************************
 *  User Category Items (like @vh etc.)
 *****************************************/
@@ -1010,6 +1032,24 @@ bool NetworkModel::isBufferIndex(const QModelIndex &index) const
 }
 
 
+const BufferItem *NetworkModel::bufferItemByIndex(const QModelIndex &index) const
+{
+    if (!index.isValid() || index.model() != this)
+        return 0;
+
+    return qobject_cast<BufferItem *>(static_cast<AbstractTreeItem *>(index.internalPointer()));
+}
+
+
+const NetworkItem *NetworkModel::networkItemByIndex(const QModelIndex &index) const
+{
+    if (!index.isValid() || index.model() != this)
+        return 0;
+
+    return qobject_cast<NetworkItem *>(static_cast<AbstractTreeItem *>(index.internalPointer()));
+}
+
+
 int NetworkModel::networkRow(NetworkId networkId) const
 {
     NetworkItem *netItem = 0;
@@ -1194,6 +1234,15 @@ MsgId NetworkModel::markerLineMsgId(BufferId bufferId) const
 }
 
 
+BufferInfo::ActivityLevel NetworkModel::bufferActivity(BufferId bufferId) const
+{
+    if (!_bufferItemCache.contains(bufferId))
+        return BufferInfo::NoActivity;
+
+    return _bufferItemCache[bufferId]->activityLevel();
+}
+
+
 // FIXME we always seem to use this (expensive) non-const version
 MsgId NetworkModel::lastSeenMsgId(const BufferId &bufferId)
 {
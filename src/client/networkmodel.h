@@ -209,6 +209,7 @@ public slots:
     void addUsersToCategory(const QList<IrcUser *> &ircUser);
     void removeUserFromCategory(IrcUser *ircUser);
     void userModeChanged(IrcUser *ircUser);
+    void userModesChanged(const QList<IrcUser *> &ircUsers);
 
 private slots:
     void ircChannelParted();
@@ -323,7 +324,10 @@ public:
 
     const Network *networkByIndex(const QModelIndex &index) const;
 
-    BufferInfo::ActivityLevel bufferActivity(const BufferInfo &buffer) const;
+    //! Typed access to the items behind an index of this model, avoiding the QVariant round-trips of data()
+    /** @return The item, or 0 if the index doesn't belong to this model or refers to a different kind of item */
+    const BufferItem *bufferItemByIndex(const QModelIndex &index) const;
+    const NetworkItem *networkItemByIndex(const QModelIndex &index) const;
 
     //! Finds a buffer with a given name in a given network
     /** This performs a linear search through all BufferItems, hence it is expensive.
@@ -338,6 +342,7 @@ public:
     BufferInfo bufferInfo(BufferId bufferId) const;
     MsgId lastSeenMsgId(BufferId bufferId) const;
     MsgId markerLineMsgId(BufferId bufferId) const;
+    BufferInfo::ActivityLevel bufferActivity(BufferId bufferId) const;
     NetworkId networkId(BufferId bufferId) const;
     QString networkName(BufferId bufferId) const;
 
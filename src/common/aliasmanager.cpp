@@ -19,6 +19,7 @@
  ***************************************************************************/
 
 #include <QDebug>
+#include <QSet>
 #include <QStringList>
 
 #include "aliasmanager.h"
@@ -74,6 +75,7 @@ void AliasManager::initSetAliases(const QVariantMap &aliases)
     }
 
     _aliases.clear();
+    _compiledExpansions.clear();
     for (int i = 0; i < names.count(); i++) {
         _aliases << Alias(names[i], expansions[i]);
     }
@@ -87,6 +89,7 @@ void AliasManager::addAlias(const QString &name, const QString &expansion)
     }
 
     _aliases << Alias(name, expansion);
+    pruneCompiledExpansions();
 
     SYNC(ARG(name), ARG(expansion))
 }
@@ -137,9 +140,9 @@ void AliasManager::processInput(const BufferInfo &info, const QString &msg_, Com
     }
     else {
         // check for aliases
-        QString cmd = msg.section(' ', 0, 0).remove(0, 1).toUpper();
+        QString cmd = msg.section(' ', 0, 0).remove(0, 1);
         for (int i = 0; i < count(); i++) {
-            if ((*this)[i].name.toUpper() == cmd) {
+            if ((*this)[i].name.compare(cmd, Qt::CaseInsensitive) == 0) {
                 expand((*this)[i].expansion, info, msg.section(' ', 1), list);
                 return;
             }
@@ -158,42 +161,11 @@ void AliasManager::expand(const QString &alias, const BufferInfo &bufferInfo, co
         return;
     }
 
-    QRegExp paramRangeR("\\$(\\d+)\\.\\.(\\d*)");
-    QStringList commands = alias.split(QRegExp("; ?"));
+    const QList<CommandTemplate> &commands = compiledExpansion(alias);
     QStringList params = msg.split(' ');
     QStringList expandedCommands;
     for (int i = 0; i < commands.count(); i++) {
-        QString command = commands[i];
-
-        // replace ranges like $1..3
-        if (!params.isEmpty()) {
-            int pos;
-            while ((pos = paramRangeR.indexIn(command)) != -1) {
-                int start = paramRangeR.cap(1).toInt();
-                bool ok;
-                int end = paramRangeR.cap(2).toInt(&ok);
-                if (!ok) {
-                    end = params.count();
-                }
-                if (end < start)
-                    command = command.replace(pos, paramRangeR.matchedLength(), QString());
-                else {
-                    command = command.replace(pos, paramRangeR.matchedLength(), QStringList(params.mid(start - 1, end - start + 1)).join(" "));
-                }
-            }
-        }
-
-        for (int j = params.count(); j > 0; j--) {
-            IrcUser *ircUser = net->ircUser(params[j - 1]);
-            command = command.replace(QString("$%1:hostname").arg(j), ircUser ? ircUser->host() : QString("*"));
-            command = command.replace(QString("$%1").arg(j), params[j - 1]);
-        }
-        command = command.replace("$0", msg);
-        command = command.replace("$channelname", bufferInfo.bufferName()); // legacy
-        command = command.replace("$channel", bufferInfo.bufferName());
-        command = command.replace("$currentnick", net->myNick()); // legacy
-        command = command.replace("$nick", net->myNick());
-        expandedCommands << command;
+        expandedCommands << expandCommand(commands[i], params, msg, bufferInfo, net);
     }
 
     while (!expandedCommands.isEmpty()) {
@@ -208,3 +180,184 @@ void AliasManager::expand(const QString &alias, const BufferInfo &bufferInfo, co
         list.append(qMakePair(bufferInfo, command));
     }
 }
+
+
+const QList<AliasManager::CommandTemplate> &AliasManager::compiledExpansion(const QString &alias)
+{
+    // aliases are parsed only once; the cache is keyed by the expansion itself, so it can't go stale
+    QHash<QString, QList<CommandTemplate> >::const_iterator it = _compiledExpansions.constFind(alias);
+    if (it != _compiledExpansions.constEnd())
+        return it.value();
+
+    // aliases may also have been edited in place, through operator[]
+    if (_compiledExpansions.count() >= _aliases.count())
+        pruneCompiledExpansions();
+
+    QList<CommandTemplate> commands;
+    foreach(const QString &command, alias.split(QRegExp("; ?"))) {
+        commands << compileCommand(command);
+    }
+    return _compiledExpansions[alias] = commands;
+}
+
+
+void AliasManager::pruneCompiledExpansions()
+{
+    if (_compiledExpansions.isEmpty())
+        return;
+
+    QSet<QString> expansions;
+    foreach(const Alias &alias, _aliases)
+        expansions << alias.expansion;
+
+    QHash<QString, QList<CommandTemplate> >::iterator it = _compiledExpansions.begin();
+    while (it != _compiledExpansions.end()) {
+        if (expansions.contains(it.key()))
+            ++it;
+        else
+            it = _compiledExpansions.erase(it);
+    }
+}
+
+
+AliasManager::CommandTemplate AliasManager::compileCommand(const QString &command)
+{
+    CommandTemplate tokens;
+    QString text;
+    int i = 0;
+    while (i < command.length()) {
+        if (command[i] != '$') {
+            text += command[i++];
+            continue;
+        }
+
+        int digitsEnd = i + 1;
+        while (digitsEnd < command.length() && command[digitsEnd].isDigit())
+            digitsEnd++;
+
+        ExpansionToken token(ExpansionToken::Text);
+        int tokenEnd = i;
+        if (digitsEnd > i + 1) {
+            QString digits = command.mid(i + 1, digitsEnd - i - 1);
+            if (command.mid(digitsEnd, 2) == "..") {
+                // ranges like $1..3 or $2..
+                int endDigitsEnd = digitsEnd + 2;
+                while (endDigitsEnd < command.length() && command[endDigitsEnd].isDigit())
+                    endDigitsEnd++;
+                token = ExpansionToken(ExpansionToken::ParamRange);
+                token.start = digits.toInt();
+                bool ok;
+                token.end = command.mid(digitsEnd + 2, endDigitsEnd - digitsEnd - 2).toInt(&ok);
+                if (!ok)
+                    token.end = -1;
+                tokenEnd = endDigitsEnd;
+            }
+            else if (digits[0] == '0') {
+                // $0 is the whole message; anything following it stays as it is
+                token = ExpansionToken(ExpansionToken::Message);
+                tokenEnd = i + 2;
+            }
+            else {
+                token = ExpansionToken(ExpansionToken::Param, digits);
+                tokenEnd = digitsEnd;
+                if (command.mid(digitsEnd, 9) == ":hostname") {
+                    token.hostname = true;
+                    tokenEnd += 9;
+                }
+            }
+        }
+        else {
+            QString rest = command.mid(i);
+            if (rest.startsWith("$channelname")) {
+                token = ExpansionToken(ExpansionToken::Channel); // legacy
+                tokenEnd = i + 12;
+            }
+            else if (rest.startsWith("$channel")) {
+                token = ExpansionToken(ExpansionToken::Channel);
+                tokenEnd = i + 8;
+            }
+            else if (rest.startsWith("$currentnick")) {
+                token = ExpansionToken(ExpansionToken::Nick); // legacy
+                tokenEnd = i + 12;
+            }
+            else if (rest.startsWith("$nick")) {
+                token = ExpansionToken(ExpansionToken::Nick);
+                tokenEnd = i + 5;
+            }
+        }
+
+        if (tokenEnd == i) {
+            // just a dollar sign
+            text += command[i++];
+            continue;
+        }
+
+        if (!text.isEmpty()) {
+            tokens << ExpansionToken(ExpansionToken::Text, text);
+            text.clear();
+        }
+        tokens << token;
+        i = tokenEnd;
+    }
+    if (!text.isEmpty())
+        tokens << ExpansionToken(ExpansionToken::Text, text);
+
+    return tokens;
+}
+
+
+QString AliasManager::expandCommand(const CommandTemplate &command, const QStringList &params, const QString &msg,
+    const BufferInfo &bufferInfo, const Network *net)
+{
+    QString result;
+    foreach(const ExpansionToken &token, command) {
+        switch (token.type) {
+        case ExpansionToken::Text:
+            result += token.text;
+            break;
+        case ExpansionToken::ParamRange: {
+            int end = token.end == -1 ? params.count() : token.end;
+            if (end >= token.start)
+                result += QStringList(params.mid(token.start - 1, end - token.start + 1)).join(" ");
+            break;
+        }
+        case ExpansionToken::Param: {
+            // Like with the replacement passes this used to be, $12 refers to the 12th parameter if there are
+            // at least that many, and to the first one followed by a literal "2" otherwise.
+            int paramLength = token.text.length();
+            int param = 0;
+            for (; paramLength > 0; paramLength--) {
+                param = token.text.left(paramLength).toInt();
+                if (param <= params.count())
+                    break;
+            }
+            QString rest = token.text.mid(paramLength);
+            if (paramLength > 0) {
+                if (token.hostname && rest.isEmpty()) {
+                    IrcUser *ircUser = net->ircUser(params[param - 1]);
+                    result += ircUser ? ircUser->host() : QString("*");
+                    break;
+                }
+                result += params[param - 1];
+            }
+            else {
+                rest = '$' + token.text;
+            }
+            result += rest;
+            if (token.hostname)
+                result += ":hostname";
+            break;
+        }
+        case ExpansionToken::Message:
+            result += msg;
+            break;
+        case ExpansionToken::Channel:
+            result += bufferInfo.bufferName();
+            break;
+        case ExpansionToken::Nick:
+            result += net->myNick();
+            break;
+        }
+    }
+    return result;
+}
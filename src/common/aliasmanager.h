@@ -48,7 +48,7 @@ public:
     inline bool contains(const QString &name) const { return indexOf(name) != -1; }
     inline bool isEmpty() const { return _aliases.isEmpty(); }
     inline int count() const { return _aliases.count(); }
-    inline void removeAt(int index) { _aliases.removeAt(index); }
+    inline void removeAt(int index) { _aliases.removeAt(index); pruneCompiledExpansions(); }
     inline Alias &operator[](int i) { return _aliases[i]; }
     inline const Alias &operator[](int i) const { return _aliases.at(i); }
     inline const AliasList &aliases() const { return _aliases; }
@@ -66,14 +66,41 @@ public slots:
     virtual void addAlias(const QString &name, const QString &expansion);
 
 protected:
-    void setAliases(const QList<Alias> &aliases) { _aliases = aliases; }
+    void setAliases(const QList<Alias> &aliases) { _aliases = aliases; pruneCompiledExpansions(); }
     virtual const Network *network(NetworkId) const = 0; // core and client require different access
 
 private:
+    //! A piece of an alias command; either literal text or one of the $ placeholders
+    struct ExpansionToken {
+        enum Type {
+            Text,
+            Param,       // $1, $2:hostname, ...
+            ParamRange,  // $1..3, $2..
+            Message,     // $0
+            Channel,     // $channel, $channelname
+            Nick         // $nick, $currentnick
+        };
+        Type type;
+        QString text; // literal text, or the digits of a Param
+        int start;
+        int end;      // -1 for open ranges
+        bool hostname;
+
+        ExpansionToken(Type type_, const QString &text_ = QString()) : type(type_), text(text_), start(0), end(-1), hostname(false) {}
+    };
+    typedef QList<ExpansionToken> CommandTemplate;
+
     void processInput(const BufferInfo &info, const QString &message, CommandList &previousCommands);
     void expand(const QString &alias, const BufferInfo &bufferInfo, const QString &msg, CommandList &previousCommands);
+    const QList<CommandTemplate> &compiledExpansion(const QString &alias);
+    //! Drops compiled expansions no alias uses anymore
+    void pruneCompiledExpansions();
+    static CommandTemplate compileCommand(const QString &command);
+    static QString expandCommand(const CommandTemplate &command, const QStringList &params, const QString &msg,
+        const BufferInfo &bufferInfo, const Network *net);
 
     AliasList _aliases;
+    QHash<QString, QList<CommandTemplate> > _compiledExpansions; // keyed by the expansion text
 };
 
 
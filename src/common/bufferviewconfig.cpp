@@ -164,6 +164,7 @@ void BufferViewConfig::initSetBufferList(const QVariantList &buffers)
     foreach(QVariant buffer, buffers) {
         _buffers << buffer.value<BufferId>();
     }
+    updateBufferPositions();
 
     emit configChanged(); // used to track changes in the settingspage
 }
@@ -176,6 +177,7 @@ void BufferViewConfig::initSetBufferList(const QList<BufferId> &buffers)
     foreach(BufferId bufferId, buffers) {
         _buffers << bufferId;
     }
+    updateBufferPositions();
 
     emit configChanged(); // used to track changes in the settingspage
 }
@@ -225,9 +227,18 @@ void BufferViewConfig::initSetTemporarilyRemovedBuffers(const QVariantList &buff
 }
 
 
+void BufferViewConfig::updateBufferPositions()
+{
+    _bufferPositions.clear();
+    _bufferPositions.reserve(_buffers.count());
+    for (int i = 0; i < _buffers.count(); i++)
+        _bufferPositions[_buffers[i]] = i;
+}
+
+
 void BufferViewConfig::addBuffer(const BufferId &bufferId, int pos)
 {
-    if (_buffers.contains(bufferId))
+    if (_bufferPositions.contains(bufferId))
         return;
 
     if (pos < 0)
@@ -242,6 +253,7 @@ void BufferViewConfig::addBuffer(const BufferId &bufferId, int pos)
         _temporarilyRemovedBuffers.remove(bufferId);
 
     _buffers.insert(pos, bufferId);
+    updateBufferPositions();
     SYNC(ARG(bufferId), ARG(pos))
     emit bufferAdded(bufferId, pos);
     emit configChanged();
@@ -250,7 +262,7 @@ void BufferViewConfig::addBuffer(const BufferId &bufferId, int pos)
 
 void BufferViewConfig::moveBuffer(const BufferId &bufferId, int pos)
 {
-    if (!_buffers.contains(bufferId))
+    if (!_bufferPositions.contains(bufferId))
         return;
 
     if (pos < 0)
@@ -258,7 +270,8 @@ void BufferViewConfig::moveBuffer(const BufferId &bufferId, int pos)
     if (pos >= _buffers.count())
         pos = _buffers.count() - 1;
 
-    _buffers.move(_buffers.indexOf(bufferId), pos);
+    _buffers.move(_bufferPositions.value(bufferId), pos);
+    updateBufferPositions();
     SYNC(ARG(bufferId), ARG(pos))
     emit bufferMoved(bufferId, pos);
     emit configChanged();
@@ -267,8 +280,10 @@ void BufferViewConfig::moveBuffer(const BufferId &bufferId, int pos)
 
 void BufferViewConfig::removeBuffer(const BufferId &bufferId)
 {
-    if (_buffers.contains(bufferId))
-        _buffers.removeAt(_buffers.indexOf(bufferId));
+    if (_bufferPositions.contains(bufferId)) {
+        _buffers.removeAt(_bufferPositions.value(bufferId));
+        updateBufferPositions();
+    }
 
     if (_removedBuffers.contains(bufferId))
         _removedBuffers.remove(bufferId);
@@ -282,8 +297,10 @@ void BufferViewConfig::removeBuffer(const BufferId &bufferId)
 
 void BufferViewConfig::removeBufferPermanently(const BufferId &bufferId)
 {
-    if (_buffers.contains(bufferId))
-        _buffers.removeAt(_buffers.indexOf(bufferId));
+    if (_bufferPositions.contains(bufferId)) {
+        _buffers.removeAt(_bufferPositions.value(bufferId));
+        updateBufferPositions();
+    }
 
     if (_temporarilyRemovedBuffers.contains(bufferId))
         _temporarilyRemovedBuffers.remove(bufferId);
@@ -79,6 +79,8 @@ public slots:
     virtual inline void requestSetBufferViewName(const QString &bufferViewName) { REQUEST(ARG(bufferViewName)) }
 
     const QList<BufferId> &bufferList() const { return _buffers; }
+    inline bool containsBuffer(const BufferId &bufferId) const { return _bufferPositions.contains(bufferId); }
+    inline int bufferPosition(const BufferId &bufferId) const { return _bufferPositions.value(bufferId, -1); }
     const QSet<BufferId> &removedBuffers() const { return _removedBuffers; }
     const QSet<BufferId> &temporarilyRemovedBuffers() const { return _temporarilyRemovedBuffers; }
 
@@ -125,6 +127,8 @@ signals:
 //   void setBufferViewNameRequested(const QString &bufferViewName);
 
 private:
+    void updateBufferPositions();
+
     int _bufferViewId;
     QString _bufferViewName;
     NetworkId _networkId;
@@ -136,6 +140,7 @@ private:
     int _allowedBufferTypes;
     int _minimumActivity;
     QList<BufferId> _buffers;
+    QHash<BufferId, int> _bufferPositions; // index into _buffers, kept in sync for fast lookups
     QSet<BufferId> _removedBuffers;
     QSet<BufferId> _temporarilyRemovedBuffers;
 };
@@ -19,6 +19,7 @@
  ***************************************************************************/
 
 #include <QCoreApplication>
+#include <QMutexLocker>
 #include <QThread>
 
 #include "internalpeer.h"
@@ -40,7 +41,8 @@ InternalPeer::InternalPeer(QObject *parent)
     : Peer(0, parent),
     _proxy(0),
     _peer(0),
-    _isOpen(true)
+    _isOpen(true),
+    _draining(false)
 {
 
 }
@@ -50,6 +52,8 @@ InternalPeer::~InternalPeer()
 {
     if (_isOpen)
         emit disconnected();
+
+    qDeleteAll(_queue);
 }
 
 
@@ -174,11 +178,56 @@ void InternalPeer::dispatch(EventType eventType, const T &msg)
     if(QThread::currentThread() == _peer->thread())
         _peer->handle(msg);
     else
-        QCoreApplication::postEvent(_peer, new PeerMessageEvent<T>(this, eventType, msg));
+        _peer->enqueue(new PeerMessageEvent<T>(this, eventType, msg));
+}
+
+
+void InternalPeer::enqueue(QEvent *event)
+{
+    // Messages between client and core come in bursts (backlog, display messages, initial sync), so rather
+    // than posting one event per message we only wake up the receiving thread once it ran out of work
+    QMutexLocker locker(&_queueMutex);
+    _queue.append(event);
+    if (_queue.count() == 1 && !_draining)
+        QCoreApplication::postEvent(this, new QEvent(QEvent::Type(QueuedMessagesEvent)));
 }
 
 
 void InternalPeer::customEvent(QEvent *event)
+{
+    if ((int)event->type() != QueuedMessagesEvent) {
+        qWarning() << Q_FUNC_INFO << "Received unknown custom event:" << event->type();
+        return;
+    }
+
+    event->accept();
+
+    // Messages are taken off the queue one by one, and nothing else is posted until it's empty. That way,
+    // a handler spinning an event loop can't get later messages handled before the rest of this batch.
+    _queueMutex.lock();
+    if (_draining) {
+        _queueMutex.unlock();
+        return;
+    }
+    _draining = true;
+    forever {
+        if (_queue.isEmpty()) {
+            _draining = false;
+            _queueMutex.unlock();
+            return;
+        }
+        QEvent *messageEvent = _queue.takeFirst();
+        _queueMutex.unlock();
+
+        handleMessageEvent(messageEvent);
+        delete messageEvent;
+
+        _queueMutex.lock();
+    }
+}
+
+
+void InternalPeer::handleMessageEvent(QEvent *event)
 {
     switch ((int)event->type()) {
         case SyncMessageEvent: {
@@ -203,9 +252,7 @@ void InternalPeer::customEvent(QEvent *event)
         }
 
         default:
-            qWarning() << Q_FUNC_INFO << "Received unknown custom event:" << event->type();
-            return;
+            qWarning() << Q_FUNC_INFO << "Received unknown message event:" << event->type();
+            break;
     }
-
-    event->accept();
 }
@@ -21,6 +21,8 @@
 #ifndef INTERNALPEER_H
 #define INTERNALPEER_H
 
+#include <QMutex>
+
 #include "peer.h"
 #include "protocol.h"
 #include "signalproxy.h"
@@ -36,7 +38,8 @@ public:
         SyncMessageEvent = QEvent::User,
         RpcCallEvent,
         InitRequestEvent,
-        InitDataEvent
+        InitDataEvent,
+        QueuedMessagesEvent
     };
 
     InternalPeer(QObject *parent = 0);
@@ -87,10 +90,18 @@ private:
     template<class T>
     void dispatch(EventType eventType, const T &msg);
 
+    //! Queues a message event from another thread, waking up this peer's thread if needed
+    void enqueue(QEvent *event);
+    void handleMessageEvent(QEvent *event);
+
 private:
     SignalProxy *_proxy;
     InternalPeer *_peer;
     bool _isOpen;
+
+    QMutex _queueMutex;
+    QList<QEvent *> _queue;
+    bool _draining;
 };
 
 
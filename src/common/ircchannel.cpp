@@ -222,6 +222,20 @@ void IrcChannel::joinIrcUser(IrcUser *ircuser)
 }
 
 
+void IrcChannel::updateIrcUsers(const QVariantMap &details)
+{
+    QVariantMap::const_iterator iter = details.constBegin();
+    while (iter != details.constEnd()) {
+        IrcUser *ircuser = network()->ircUser(iter.key());
+        if (ircuser)
+            ircuser->applyDetails(iter.value().toMap());
+        ++iter;
+    }
+
+    SYNC(ARG(details))
+}
+
+
 void IrcChannel::part(IrcUser *ircuser)
 {
     if (isKnownUser(ircuser)) {
@@ -475,12 +489,65 @@ void IrcChannel::ircUserNickSet(QString nick)
 // NOTE: the behavior of addChannelMode and removeChannelMode depends on the type of mode
 // see list above for chanmode types
 void IrcChannel::addChannelMode(const QChar &mode, const QString &value)
+{
+    if (addChannelModeInternal(mode, value))
+        SYNC(ARG(mode), ARG(value))
+}
+
+
+void IrcChannel::removeChannelMode(const QChar &mode, const QString &value)
+{
+    if (removeChannelModeInternal(mode, value))
+        SYNC(ARG(mode), ARG(value))
+}
+
+
+void IrcChannel::changeModes(const QString &modes, const QStringList &values)
+{
+    if (modes.length() != 2 * values.count()) {
+        qWarning() << "IrcChannel::changeModes(): number of modes does not match number of values!";
+        return;
+    }
+
+    const QString prefixModes = network()->prefixModes();
+    QList<IrcUser *> changedUsers;
+    for (int i = 0; i < values.count(); i++) {
+        bool add = (modes[2 * i] == '+');
+        QChar mode = modes[2 * i + 1];
+
+        if (!prefixModes.contains(mode)) {
+            if (add)
+                addChannelModeInternal(mode, values[i]);
+            else
+                removeChannelModeInternal(mode, values[i]);
+            continue;
+        }
+
+        IrcUser *ircuser = network()->ircUser(values[i]);
+        if (!isKnownUser(ircuser) || _userModes[ircuser].contains(mode) == add)
+            continue;
+
+        if (add)
+            _userModes[ircuser] += mode;
+        else
+            _userModes[ircuser].remove(mode);
+        if (!changedUsers.contains(ircuser))
+            changedUsers << ircuser;
+    }
+
+    SYNC(ARG(modes), ARG(values))
+    if (!changedUsers.isEmpty())
+        emit ircUserModesChanged(changedUsers);
+}
+
+
+bool IrcChannel::addChannelModeInternal(const QChar &mode, const QString &value)
 {
     Network::ChannelModeType modeType = network()->channelModeType(mode);
 
     switch (modeType) {
     case Network::NOT_A_CHANMODE:
-        return;
+        return false;
     case Network::A_CHANMODE:
         if (!_A_channelModes.contains(mode))
             _A_channelModes[mode] = QStringList(value);
@@ -500,17 +567,17 @@ void IrcChannel::addChannelMode(const QChar &mode, const QString &value)
         _D_channelModes << mode;
         break;
     }
-    SYNC(ARG(mode), ARG(value))
+    return true;
 }
 
 
-void IrcChannel::removeChannelMode(const QChar &mode, const QString &value)
+bool IrcChannel::removeChannelModeInternal(const QChar &mode, const QString &value)
 {
     Network::ChannelModeType modeType = network()->channelModeType(mode);
 
     switch (modeType) {
     case Network::NOT_A_CHANMODE:
-        return;
+        return false;
     case Network::A_CHANMODE:
         if (_A_channelModes.contains(mode))
             _A_channelModes[mode].removeAll(value);
@@ -528,7 +595,7 @@ void IrcChannel::removeChannelMode(const QChar &mode, const QString &value)
         _D_channelModes.remove(mode);
         break;
     }
-    SYNC(ARG(mode), ARG(value))
+    return true;
 }
 
 
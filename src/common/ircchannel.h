@@ -84,6 +84,11 @@ public slots:
     void joinIrcUsers(const QStringList &nicks, const QStringList &modes);
     void joinIrcUser(IrcUser *ircuser);
 
+    //! Applies the details of many members at once, e.g. from a channel's WHO reply
+    /** \param details Maps nicks to the changed details (see IrcUser::applyDetails())
+     */
+    void updateIrcUsers(const QVariantMap &details);
+
     void part(IrcUser *ircuser);
     void part(const QString &nick);
 
@@ -99,6 +104,12 @@ public slots:
     void addChannelMode(const QChar &mode, const QString &value);
     void removeChannelMode(const QChar &mode, const QString &value);
 
+    //! Applies all changes of a MODE line at once
+    /** \param modes  The changes as pairs of sign and mode, e.g. "+o+o-b"
+     *  \param values One value per change: the nick for user modes, the (possibly empty) parameter otherwise
+     */
+    void changeModes(const QString &modes, const QStringList &values);
+
     // init geters
     QVariantMap initUserModes() const;
     QVariantMap initChanModes() const;
@@ -124,6 +135,7 @@ signals:
     void ircUserModeAdded(IrcUser *ircuser, QString mode);
     void ircUserModeRemoved(IrcUser *ircuser, QString mode);
     void ircUserModesSet(IrcUser *ircuser, QString modes);
+    void ircUserModesChanged(QList<IrcUser *> ircusers);
 
     void parted(); // convenience signal emitted before channels destruction
 
@@ -132,6 +144,9 @@ private slots:
     void ircUserNickSet(QString nick);
 
 private:
+    bool addChannelModeInternal(const QChar &mode, const QString &value);
+    bool removeChannelModeInternal(const QChar &mode, const QString &value);
+
     bool _initialized;
     QString _name;
     QString _topic;
@@ -31,6 +31,11 @@
  *  2.) RPL_LIST fills on the core the list of available channels
  *      when RPL_LISTEND is received the clients will be informed, that they can pull the data
  *  3.) client pulls the data by calling requestChannelList again. receiving the data in receiveChannelList
+ *
+ * Cores supporting Quassel::PagedChannelList additionally hand out the list in pages while it is
+ * still being received: the client repeatedly calls requestChannelListPage() with the number of
+ * entries it already has and receives the next chunk in receiveChannelListPage(). An empty page
+ * means that no further data is available yet (or at all, once reportFinishedList() was called).
  */
 class IrcListHelper : public SyncableObject
 {
@@ -50,6 +55,8 @@ public:
 public slots:
     inline virtual QVariantList requestChannelList(const NetworkId &netId, const QStringList &channelFilters) { REQUEST(ARG(netId), ARG(channelFilters)); return QVariantList(); }
     inline virtual void receiveChannelList(const NetworkId &, const QStringList &, const QVariantList &) {};
+    inline virtual QVariantList requestChannelListPage(const NetworkId &netId, int offset) { REQUEST(ARG(netId), ARG(offset)); return QVariantList(); }
+    inline virtual void receiveChannelListPage(const NetworkId &, int, const QVariantList &) {};
     inline virtual void reportFinishedList(const NetworkId &netId) { SYNC(ARG(netId)) }
     inline virtual void reportError(const QString &error) { SYNC(ARG(error)) }
 };
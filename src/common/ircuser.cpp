@@ -220,6 +220,50 @@ void IrcUser::setHost(const QString &host)
 }
 
 
+QVariantMap IrcUser::applyDetails(const QVariantMap &details)
+{
+    QVariantMap changed;
+    QVariantMap::const_iterator iter = details.constBegin();
+    while (iter != details.constEnd()) {
+        const QString &key = iter.key();
+        if (key == "away") {
+            bool away = iter.value().toBool();
+            if (away != _away) {
+                _away = away;
+                changed[key] = away;
+                emit awaySet(away);
+            }
+        }
+        else {
+            QString *field = 0;
+            if (key == "user")
+                field = &_user;
+            else if (key == "host")
+                field = &_host;
+            else if (key == "realName")
+                field = &_realName;
+            else if (key == "server")
+                field = &_server;
+
+            QString value = iter.value().toString();
+            if (field && !value.isEmpty() && *field != value) {
+                *field = value;
+                changed[key] = value;
+            }
+        }
+        ++iter;
+    }
+    return changed;
+}
+
+
+void IrcUser::syncDetails(const QVariantMap &details)
+{
+    if (!details.isEmpty())
+        SYNC_OTHER(update, ARG(details))
+}
+
+
 void IrcUser::setNick(const QString &nick)
 {
     if (!nick.isEmpty() && nick != _nick) {
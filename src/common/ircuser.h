@@ -99,6 +99,15 @@ public :
     inline QDateTime lastSpokenTo(BufferId id) const { return _lastSpokenTo.value(id); }
     void setLastSpokenTo(BufferId id, const QDateTime &time);
 
+    //! Sets the user details found in WHO replies (user, host, realName, away, server) at once
+    /** Unlike the individual setters, this doesn't sync anything. Use syncDetails() for that.
+     *  \return The details that actually changed
+     */
+    QVariantMap applyDetails(const QVariantMap &details);
+
+    //! Syncs several changed details as a single update() call
+    void syncDetails(const QVariantMap &details);
+
 public slots:
     void setUser(const QString &user);
     void setHost(const QString &host);
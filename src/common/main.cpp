@@ -152,6 +152,9 @@ int main(int argc, char **argv)
     cliParser->addSwitch("debugbufferswitches", 0, "Enables debugging for bufferswitches");
     cliParser->addSwitch("debugmodel", 0, "Enables debugging for models");
     cliParser->addSwitch("hidewindow", 0, "Start the client minimized to the system tray");
+    cliParser->addSwitch("profile-startup", 0, "Print a timeline of the startup phases once the client is usable");
+    cliParser->addSwitch("startup-benchmark", 0, "Connect to the last used core, print the startup timeline and quit");
+    cliParser->addOption("startup-benchmark-timeout", 0, "Give up on --startup-benchmark after this many seconds", "seconds", "300");
 #endif
 #ifndef BUILD_QTUI
     // put core-only arguments here
@@ -172,6 +175,9 @@ int main(int argc, char **argv)
     cliParser->addSwitch("require-ssl", 0, "Require SSL for remote (non-loopback) client connections");
 #endif
     cliParser->addSwitch("enable-experimental-dcc", 0, "Enable highly experimental and unfinished support for CTCP DCC (DANGEROUS)");
+    cliParser->addOption("dcc-dir", 0, "Store files received via DCC in this directory on the core, and allow sending files from it", "path");
+    cliParser->addOption("dcc-max-size", 0, "Largest file (in MiB) that may be stored in --dcc-dir", "size", "1024");
+    cliParser->addOption("dcc-quota", 0, "Space (in MiB) each user's files may take up in --dcc-dir", "size", "4096");
 #endif
 
 #ifdef HAVE_KDE4
@@ -25,7 +25,7 @@
 #include <QDataStream>
 
 Message::Message(const BufferInfo &bufferInfo, Type type, const QString &contents, const QString &sender, Flags flags)
-    : _timestamp(QDateTime::currentDateTime().toUTC()),
+    : _timestamp(QDateTime::currentMSecsSinceEpoch()),
     _bufferInfo(bufferInfo),
     _contents(contents),
     _sender(sender),
@@ -36,7 +36,7 @@ Message::Message(const BufferInfo &bufferInfo, Type type, const QString &content
 
 
 Message::Message(const QDateTime &ts, const BufferInfo &bufferInfo, Type type, const QString &contents, const QString &sender, Flags flags)
-    : _timestamp(ts),
+    : _timestamp(ts.toMSecsSinceEpoch()),
     _bufferInfo(bufferInfo),
     _contents(contents),
     _sender(sender),
@@ -46,9 +46,18 @@ Message::Message(const QDateTime &ts, const BufferInfo &bufferInfo, Type type, c
 }
 
 
+QDateTime Message::timestamp() const
+{
+    QDateTime ts;
+    ts.setTimeSpec(Qt::UTC);
+    ts.setMSecsSinceEpoch(_timestamp);
+    return ts;
+}
+
+
 QDataStream &operator<<(QDataStream &out, const Message &msg)
 {
-    out << msg.msgId() << (quint32)msg.timestamp().toTime_t() << (quint32)msg.type() << (quint8)msg.flags()
+    out << msg.msgId() << (quint32)(msg.timestampMsecs() / 1000) << (quint32)msg.type() << (quint8)msg.flags()
     << msg.bufferInfo() << msg.sender().toUtf8() << msg.contents().toUtf8();
     return out;
 }
@@ -65,7 +74,7 @@ QDataStream &operator>>(QDataStream &in, Message &msg)
     msg._type = (Message::Type)t;
     msg._flags = (Message::Flags)f;
     msg._bufferInfo = buf;
-    msg._timestamp = QDateTime::fromTime_t(ts);
+    msg._timestamp = (qint64)ts * 1000;
     msg._sender = QString::fromUtf8(s);
     msg._contents = QString::fromUtf8(m);
     return in;
@@ -74,21 +74,25 @@ public:
     inline void setMsgId(MsgId id) { _msgId = id; }
 
     inline const BufferInfo &bufferInfo() const { return _bufferInfo; }
+    inline void setBufferInfo(const BufferInfo &bufferInfo) { _bufferInfo = bufferInfo; }
     inline const BufferId &bufferId() const { return _bufferInfo.bufferId(); }
     inline void setBufferId(BufferId id) { _bufferInfo.setBufferId(id); }
     inline const QString &contents() const { return _contents; }
     inline const QString &sender() const { return _sender; }
+    inline void setSender(const QString &sender) { _sender = sender; }
     inline Type type() const { return _type; }
     inline Flags flags() const { return _flags; }
     inline void setFlags(Flags flags) { _flags = flags; }
-    inline const QDateTime &timestamp() const { return _timestamp; }
+    QDateTime timestamp() const;
+    //! The timestamp in milliseconds since the epoch, which is cheap to compare and store
+    inline qint64 timestampMsecs() const { return _timestamp; }
 
     inline bool isValid() const { return _msgId.isValid(); }
 
     inline bool operator<(const Message &other) const { return _msgId < other._msgId; }
 
 private:
-    QDateTime _timestamp;
+    qint64 _timestamp;
     MsgId _msgId;
     BufferInfo _bufferInfo;
     QString _contents;
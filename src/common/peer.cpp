@@ -23,6 +23,7 @@
 Peer::Peer(AuthHandler *authHandler, QObject *parent)
     : QObject(parent)
     , _authHandler(authHandler)
+    , _features(0)
 {
 
 }
@@ -24,6 +24,7 @@
 #include <QTcpSocket>
 
 #include "datastreampeer.h"
+#include "../../signalproxy.h"
 
 using namespace Protocol;
 
@@ -57,18 +58,21 @@ void DataStreamPeer::processMessage(const QByteArray &msg)
 {
     QDataStream stream(msg);
     stream.setVersion(QDataStream::Qt_4_2);
+
+    // with a sigproxy set, the handshake is over and we can decode packed funcs lazily
+    if (signalProxy()) {
+        handlePackedFunc(stream);
+        return;
+    }
+
+    // otherwise we're in handshake mode
     QVariantList list;
     stream >> list;
     if (stream.status() != QDataStream::Ok) {
         close("Peer sent corrupt data, closing down!");
         return;
     }
-
-    // if no sigproxy is set, we're in handshake mode
-    if (!signalProxy())
-        handleHandshakeMessage(list);
-    else
-        handlePackedFunc(list);
+    handleHandshakeMessage(list);
 }
 
 
@@ -116,7 +120,7 @@ void DataStreamPeer::handleHandshakeMessage(const QVariantList &mapData)
     }
 
     if (msgType == "ClientInit") {
-        handle(RegisterClient(m["ClientVersion"].toString(), m["ClientDate"].toString(), false)); // UseSsl obsolete
+        handle(RegisterClient(m["ClientVersion"].toString(), m["ClientDate"].toString(), false, m["ClientFeatures"].toUInt())); // UseSsl obsolete
     }
 
     else if (msgType == "ClientInitReject") {
@@ -168,6 +172,7 @@ void DataStreamPeer::dispatch(const RegisterClient &msg) {
     m["MsgType"] = "ClientInit";
     m["ClientVersion"] = msg.clientVersion;
     m["ClientDate"] = msg.buildDate;
+    m["ClientFeatures"] = msg.clientFeatures;
 
     writeMessage(m);
 }
@@ -279,81 +284,148 @@ void DataStreamPeer::dispatch(const SessionState &msg)
 
 /*** Standard messages ***/
 
-void DataStreamPeer::handlePackedFunc(const QVariantList &packedFunc)
+/* Standard messages are decoded straight from the stream: the header (request type, class and object name,
+ * slot) is read first, and the remaining elements are only decoded once we know that someone is going to
+ * receive them.  This saves decoding (and copying around) the payload of messages for unknown receivers.
+ */
+
+// Reads the next element of a packed func from the stream
+static QVariant readElement(QDataStream &stream)
+{
+    QVariant element;
+    stream >> element;
+    return element;
+}
+
+
+// Reads the given number of remaining elements of a packed func from the stream
+static QVariantList readElements(QDataStream &stream, quint32 count)
 {
-    QVariantList params(packedFunc);
+    QVariantList elements;
+    // don't trust the count blindly; every element takes at least five bytes on the wire
+    elements.reserve(qMin<qint64>(count, stream.device()->bytesAvailable() / 5));
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i)
+        elements << readElement(stream);
+    return elements;
+}
 
-    if (params.isEmpty()) {
-        qWarning() << Q_FUNC_INFO << "Received incompatible data:" << packedFunc;
+
+void DataStreamPeer::handlePackedFunc(QDataStream &stream)
+{
+    quint32 count;
+    stream >> count;
+    if (stream.status() != QDataStream::Ok || !count) {
+        qWarning() << Q_FUNC_INFO << "Received incompatible data!";
         return;
     }
 
     // TODO: make sure that this is a valid request type
-    RequestType requestType = (RequestType)params.takeFirst().value<qint16>();
+    RequestType requestType = (RequestType)readElement(stream).value<qint16>();
+    quint32 paramCount = count - 1;
+
     switch (requestType) {
         case Sync: {
-            if (params.count() < 3) {
-                qWarning() << Q_FUNC_INFO << "Received invalid sync call:" << params;
+            if (paramCount < 3) {
+                qWarning() << Q_FUNC_INFO << "Received invalid sync call with" << paramCount << "params";
                 return;
             }
-            QByteArray className = params.takeFirst().toByteArray();
-            QString objectName = QString::fromUtf8(params.takeFirst().toByteArray());
-            QByteArray slotName = params.takeFirst().toByteArray();
+            QByteArray className = readElement(stream).toByteArray();
+            QString objectName = QString::fromUtf8(readElement(stream).toByteArray());
+            QByteArray slotName = readElement(stream).toByteArray();
+            if (stream.status() != QDataStream::Ok)
+                break;
+            if (!signalProxy()->hasSyncReceiver(className, objectName)) {
+                qWarning() << QString("no registered receiver for sync call: %1::%2 (objectName=\"%3\")")
+                              .arg(className, slotName, objectName);
+                return;
+            }
+            QVariantList params = readElements(stream, paramCount - 3);
+            if (stream.status() != QDataStream::Ok)
+                break;
             handle(Protocol::SyncMessage(className, objectName, slotName, params));
-            break;
+            return;
         }
         case RpcCall: {
-            if (params.empty()) {
+            if (!paramCount) {
                 qWarning() << Q_FUNC_INFO << "Received empty RPC call!";
                 return;
             }
-            QByteArray slotName = params.takeFirst().toByteArray();
+            QByteArray slotName = readElement(stream).toByteArray();
+            if (stream.status() != QDataStream::Ok)
+                break;
+            if (!signalProxy()->hasRpcReceiver(slotName))
+                return;
+            QVariantList params = readElements(stream, paramCount - 1);
+            if (stream.status() != QDataStream::Ok)
+                break;
             handle(Protocol::RpcCall(slotName, params));
-            break;
+            return;
         }
         case InitRequest: {
-            if (params.count() != 2) {
-                qWarning() << Q_FUNC_INFO << "Received invalid InitRequest:" << params;
+            if (paramCount != 2) {
+                qWarning() << Q_FUNC_INFO << "Received invalid InitRequest with" << paramCount << "params";
                 return;
             }
-            QByteArray className = params[0].toByteArray();
-            QString objectName = QString::fromUtf8(params[1].toByteArray());
+            QByteArray className = readElement(stream).toByteArray();
+            QString objectName = QString::fromUtf8(readElement(stream).toByteArray());
+            if (stream.status() != QDataStream::Ok)
+                break;
             handle(Protocol::InitRequest(className, objectName));
-            break;
+            return;
         }
         case InitData: {
-            if (params.count() < 2) {
-                qWarning() << Q_FUNC_INFO << "Received invalid InitData:" << params;
+            if (paramCount < 2) {
+                qWarning() << Q_FUNC_INFO << "Received invalid InitData with" << paramCount << "params";
+                return;
+            }
+            QByteArray className = readElement(stream).toByteArray();
+            QString objectName = QString::fromUtf8(readElement(stream).toByteArray());
+            if (stream.status() != QDataStream::Ok)
+                break;
+            if (!signalProxy()->hasSyncReceiver(className, objectName)) {
+                qWarning() << Q_FUNC_INFO << "Received InitData for unregistered object:" << className << objectName;
                 return;
             }
-            QByteArray className = params.takeFirst().toByteArray();
-            QString objectName = QString::fromUtf8(params.takeFirst().toByteArray());
             QVariantMap initData;
-            for (int i = 0; i < params.count()/2; ++i)
-                initData[QString::fromUtf8(params[2*i].toByteArray())] = params[2*i+1];
+            for (quint32 i = 0; i < (paramCount - 2)/2 && stream.status() == QDataStream::Ok; ++i) {
+                QString key = QString::fromUtf8(readElement(stream).toByteArray());
+                initData[key] = readElement(stream);
+            }
+            if (stream.status() != QDataStream::Ok)
+                break;
             handle(Protocol::InitData(className, objectName, initData));
-            break;
+            return;
         }
         case HeartBeat: {
-            if (params.count() != 1) {
-                qWarning() << Q_FUNC_INFO << "Received invalid HeartBeat:" << params;
+            if (paramCount != 1) {
+                qWarning() << Q_FUNC_INFO << "Received invalid HeartBeat with" << paramCount << "params";
                 return;
             }
             // Note: QDateTime instead of QTime as in the legacy protocol!
-            handle(Protocol::HeartBeat(params[0].toDateTime()));
-            break;
+            QDateTime timestamp = readElement(stream).toDateTime();
+            if (stream.status() != QDataStream::Ok)
+                break;
+            handle(Protocol::HeartBeat(timestamp));
+            return;
         }
         case HeartBeatReply: {
-            if (params.count() != 1) {
-                qWarning() << Q_FUNC_INFO << "Received invalid HeartBeat:" << params;
+            if (paramCount != 1) {
+                qWarning() << Q_FUNC_INFO << "Received invalid HeartBeatReply with" << paramCount << "params";
                 return;
             }
             // Note: QDateTime instead of QTime as in the legacy protocol!
-            handle(Protocol::HeartBeatReply(params[0].toDateTime()));
-            break;
+            QDateTime timestamp = readElement(stream).toDateTime();
+            if (stream.status() != QDataStream::Ok)
+                break;
+            handle(Protocol::HeartBeatReply(timestamp));
+            return;
         }
-
+        default:
+            return;
     }
+
+    // we only get here if the stream ran dry or contained garbage
+    close("Peer sent corrupt data, closing down!");
 }
 
 
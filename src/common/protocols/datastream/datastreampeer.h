@@ -77,7 +77,7 @@ private:
     void processMessage(const QByteArray &msg);
 
     void handleHandshakeMessage(const QVariantList &mapData);
-    void handlePackedFunc(const QVariantList &packedFunc);
+    void handlePackedFunc(QDataStream &stream);
     void dispatchPackedFunc(const QVariantList &packedFunc);
 };
 
@@ -72,8 +72,15 @@ public:
         SaslExternal = 0x0004,
         HideInactiveNetworks = 0x0008,
         PasswordChange = 0x0010,
-
-        NumFeatures = 0x0010
+        PagedChannelList = 0x0020,
+        TransferFlowControl = 0x0040,
+        BulkUserInput = 0x0080,
+        SyncInterest = 0x0100,
+        BatchedUserDetails = 0x0200,
+        BatchedModeChanges = 0x0400,
+        StoredTransferConnection = 0x0800,
+
+        NumFeatures = 0x0800
     };
     Q_DECLARE_FLAGS(Features, Feature);
 
@@ -18,20 +18,111 @@
  *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.         *
  ***************************************************************************/
 
+#include <stdlib.h>
+
+#include <QEvent>
+#include <QMutexLocker>
 #include <QStringList>
+#include <QThread>
 
 #include "settings.h"
 
 const int VERSION = 1;
+const int syncDelay = 1000; // ms
 
 QHash<QString, QVariant> Settings::settingsCache;
 QHash<QString, SettingsChangeNotifier *> Settings::settingsChangeNotifier;
 
+#define create_qsettings QMutexLocker locker(SettingsBackend::instance()->mutex()); \
+    QSettings &s = *SettingsBackend::instance()->settings(appName, fileName(), format())
+
+// QSettings syncs itself from the event loop after every change. We take care of that ourselves, so that
+// changes are written in batches and never while another thread holds the backend's mutex.
+class SharedSettings : public QSettings
+{
+public:
+    SharedSettings(const QString &organization, const QString &application) : QSettings(organization, application) {}
+    SharedSettings(const QString &fileName, Format format) : QSettings(fileName, format) {}
+
+protected:
+    bool event(QEvent *event)
+    {
+        if (event->type() == QEvent::UpdateRequest)
+            return true;
+        return QSettings::event(event);
+    }
+};
+
+
+SettingsBackend *SettingsBackend::instance()
+{
+    static SettingsBackend *backend = new SettingsBackend();
+    return backend;
+}
+
+
+SettingsBackend::SettingsBackend()
+    : QObject(0),
+    _syncTimer(this)
+{
+    // the timer needs an event loop, so we live in the main thread; being our child, it moves along with us
+    if (QCoreApplication::instance())
+        moveToThread(QCoreApplication::instance()->thread());
+
+    _syncTimer.setSingleShot(true);
+    _syncTimer.setInterval(syncDelay);
+    connect(&_syncTimer, SIGNAL(timeout()), SLOT(sync()));
+
+    // exit() (as used by the core's command line tools) skips the post routines, so catch that as well
+    qAddPostRoutine(syncAtExit);
+    atexit(syncAtExit);
+}
+
+
+QSettings *SettingsBackend::settings(const QString &appName, const QString &fileName, QSettings::Format format)
+{
+    QSettings *&s = _settings[appName];
+    if (!s) {
 #ifdef Q_OS_MAC
-#  define create_qsettings QSettings s(QCoreApplication::organizationDomain(), appName)
+        Q_UNUSED(fileName)
+        Q_UNUSED(format)
+        s = new SharedSettings(QCoreApplication::organizationDomain(), appName);
 #else
-#  define create_qsettings QSettings s(fileName(), format())
+        s = new SharedSettings(fileName, format);
 #endif
+    }
+    return s;
+}
+
+
+void SettingsBackend::scheduleSync()
+{
+    QMetaObject::invokeMethod(this, "startSyncTimer");
+}
+
+
+void SettingsBackend::startSyncTimer()
+{
+    if (!_syncTimer.isActive())
+        _syncTimer.start();
+}
+
+
+void SettingsBackend::sync()
+{
+    QMutexLocker locker(&_mutex);
+    foreach(QSettings *s, _settings)
+        s->sync();
+}
+
+
+void SettingsBackend::syncAtExit()
+{
+    SettingsBackend *backend = instance();
+    backend->_syncTimer.stop();
+    backend->sync();
+}
+
 
 // Settings::Settings(QString group_, QString appName_)
 //   : group(group_),
@@ -80,6 +171,7 @@ uint Settings::version()
     if (!ver) {
         // No version, so create one
         s.setValue("Config/Version", VERSION);
+        SettingsBackend::instance()->scheduleSync();
         return VERSION;
     }
     return ver;
@@ -131,8 +223,11 @@ QStringList Settings::localChildGroups(const QString &rootkey)
 void Settings::setLocalValue(const QString &key, const QVariant &data)
 {
     QString normKey = normalizedKey(group, key);
-    create_qsettings;
-    s.setValue(normKey, data);
+    {
+        create_qsettings;
+        s.setValue(normKey, data);
+    }
+    SettingsBackend::instance()->scheduleSync();
     setCacheValue(normKey, data);
     if (hasNotifier(normKey)) {
         emit notifier(normKey)->valueChanged(data);
@@ -153,10 +248,13 @@ const QVariant &Settings::localValue(const QString &key, const QVariant &def)
 
 void Settings::removeLocalKey(const QString &key)
 {
-    create_qsettings;
-    s.beginGroup(group);
-    s.remove(key);
-    s.endGroup();
+    {
+        create_qsettings;
+        s.beginGroup(group);
+        s.remove(key);
+        s.endGroup();
+    }
+    SettingsBackend::instance()->scheduleSync();
     QString normKey = normalizedKey(group, key);
     if (isCached(normKey))
         settingsCache.remove(normKey);
@@ -23,8 +23,10 @@
 
 #include <QCoreApplication>
 #include <QHash>
+#include <QMutex>
 #include <QSettings>
 #include <QString>
+#include <QTimer>
 #include <QVariant>
 
 #include "quassel.h"
@@ -41,6 +43,41 @@ private:
 };
 
 
+//! Holds the QSettings instances shared by all Settings objects and writes them back in batches
+/** Rather than constructing (and thereby syncing) a QSettings object for every access, there is one
+ *  per settings file. Changes are kept in memory and written to disk shortly after the first unsynced
+ *  change, as well as on exit. The QSettings instances may only be accessed with mutex() locked.
+ */
+class SettingsBackend : public QObject
+{
+    Q_OBJECT
+
+public:
+    static SettingsBackend *instance();
+
+    inline QMutex *mutex() { return &_mutex; }
+    QSettings *settings(const QString &appName, const QString &fileName, QSettings::Format format);
+
+    //! Makes sure pending changes are written to disk soon; may be called from any thread
+    void scheduleSync();
+
+public slots:
+    void sync();
+
+private slots:
+    void startSyncTimer();
+
+private:
+    SettingsBackend();
+
+    static void syncAtExit();
+
+    QMutex _mutex;
+    QHash<QString, QSettings *> _settings;
+    QTimer _syncTimer;
+};
+
+
 class Settings
 {
 public:
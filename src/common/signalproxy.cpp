@@ -32,6 +32,7 @@
 
 #include "peer.h"
 #include "protocol.h"
+#include "startupprofiler.h"
 #include "syncableobject.h"
 #include "util.h"
 #include "types.h"
@@ -525,6 +526,13 @@ void SignalProxy::dispatch(Peer *peer, const T &protoMessage)
 }
 
 
+bool SignalProxy::hasSyncReceiver(const QByteArray &className, const QString &objectName) const
+{
+    QHash<QByteArray, ObjectId>::const_iterator classIter = _syncSlave.constFind(className);
+    return classIter != _syncSlave.constEnd() && classIter->contains(objectName);
+}
+
+
 void SignalProxy::handle(Peer *peer, const SyncMessage &syncMessage)
 {
     if (!_syncSlave.contains(syncMessage.className) || !_syncSlave[syncMessage.className].contains(syncMessage.objectName)) {
@@ -608,6 +616,12 @@ void SignalProxy::handle(Peer *peer, const InitData &initData)
     }
 
     SyncableObject *obj = _syncSlave[initData.className][initData.objectName];
+    if (StartupProfiler::isEnabled()) {
+        qint64 start = StartupProfiler::elapsed();
+        setInitData(obj, initData.initData);
+        StartupProfiler::addSample("InitData " + QString::fromLatin1(initData.className), StartupProfiler::elapsed() - start);
+        return;
+    }
     setInitData(obj, initData.initData);
 }
 
@@ -657,7 +671,7 @@ bool SignalProxy::invokeSlot(QObject *receiver, int methodId, const QVariantList
             qWarning() << "                            - make sure all your data types are known by the Qt MetaSystem";
             return false;
         }
-        if (args[i] != QMetaType::type(params[i].typeName())) {
+        if (args[i] != params[i].userType()) {
             qWarning() << "SignalProxy::invokeSlot(): incompatible param types to invoke" << eMeta->methodName(methodId);
             return false;
         }
@@ -747,7 +761,8 @@ void SignalProxy::sync_call__(const SyncableObject *obj, SignalProxy::ProxyMode
 
     QVariantList params;
 
-    const QList<int> &argTypes = eMeta->argTypes(eMeta->methodId(QByteArray(funcname)));
+    const QByteArray slotName(funcname);
+    const QList<int> &argTypes = eMeta->argTypes(eMeta->methodId(slotName));
 
     for (int i = 0; i < argTypes.size(); i++) {
         if (argTypes[i] == 0) {
@@ -760,9 +775,36 @@ void SignalProxy::sync_call__(const SyncableObject *obj, SignalProxy::ProxyMode
 
     if (argTypes.size() >= 1 && argTypes[0] == qMetaTypeId<PeerPtr>() && proxyMode() == SignalProxy::Server) {
         Peer *peer = params[0].value<PeerPtr>();
-        dispatch(peer, SyncMessage(eMeta->metaObject()->className(), obj->objectName(), QByteArray(funcname), params));
-    } else
-        dispatch(SyncMessage(eMeta->metaObject()->className(), obj->objectName(), QByteArray(funcname), params));
+        dispatch(peer, SyncMessage(eMeta->metaObject()->className(), obj->objectName(), slotName, params));
+    } else {
+        SyncMessage syncMessage(eMeta->metaObject()->className(), obj->objectName(), slotName, params);
+        foreach (Peer *peer, _peers) {
+            if (obj->isSyncedTo(peer, slotName))
+                dispatch(peer, syncMessage);
+        }
+    }
+}
+
+
+void SignalProxy::sendUpdate(Peer *peer, SyncableObject *obj)
+{
+    sendUpdate(peer, obj, initData(obj));
+}
+
+
+void SignalProxy::sendUpdate(Peer *peer, SyncableObject *obj, const QVariantMap &properties)
+{
+    sendSync(peer, obj, "update", QVariantList() << QVariant(properties));
+}
+
+
+void SignalProxy::sendSync(Peer *peer, SyncableObject *obj, const QByteArray &slotName, const QVariantList &params)
+{
+    if (proxyMode() != Server)
+        return;
+
+    ExtendedMetaObject *eMeta = extendedMetaObject(obj);
+    dispatch(peer, SyncMessage(eMeta->metaObject()->className(), obj->objectName(), slotName, params));
 }
 
 
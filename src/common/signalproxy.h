@@ -68,16 +68,33 @@ public:
     void synchronize(SyncableObject *obj);
     void stopSynchronize(SyncableObject *obj);
 
+    //! Sends the complete current state of a synced object to a single peer
+    /** Used to catch up a peer that has been skipped by SyncableObject::isSyncedTo() before.
+     */
+    void sendUpdate(Peer *peer, SyncableObject *obj);
+    //! Sends the given properties of a synced object to a single peer
+    void sendUpdate(Peer *peer, SyncableObject *obj, const QVariantMap &properties);
+    //! Sends a sync call to a single peer, bypassing SyncableObject::isSyncedTo()
+    void sendSync(Peer *peer, SyncableObject *obj, const QByteArray &slotName, const QVariantList &params);
+
     class ExtendedMetaObject;
     ExtendedMetaObject *extendedMetaObject(const QMetaObject *meta) const;
     ExtendedMetaObject *createExtendedMetaObject(const QMetaObject *meta, bool checkConflicts = false);
     inline ExtendedMetaObject *extendedMetaObject(const QObject *obj) const { return extendedMetaObject(metaObject(obj)); }
     inline ExtendedMetaObject *createExtendedMetaObject(const QObject *obj, bool checkConflicts = false) { return createExtendedMetaObject(metaObject(obj), checkConflicts); }
 
+    //! Checks whether a SyncMessage or InitData for the given object would be delivered
+    /** Lets peers skip decoding the payload of messages nobody is interested in.
+     */
+    bool hasSyncReceiver(const QByteArray &className, const QString &objectName) const;
+    //! Checks whether any slot is attached to the given RPC signal
+    inline bool hasRpcReceiver(const QByteArray &slotName) const { return _attachedSlots.contains(slotName); }
+
     bool isSecure() const { return _secure; }
     void dumpProxyStats();
     void dumpSyncMap(SyncableObject *object);
     inline int peerCount() const { return _peers.size(); }
+    inline const QSet<Peer *> &peers() const { return _peers; }
 
 public slots:
     void detachObject(QObject *obj);
@@ -0,0 +1,171 @@
+/***************************************************************************
+ *   Copyright (C) 2005-2015 by the Quassel Project                        *
+ *   devel@quassel-irc.org                                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3.                                           *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.         *
+ ***************************************************************************/
+
+#include "startupprofiler.h"
+
+#include <QCoreApplication>
+#include <QTextStream>
+#include <QTimer>
+
+#include <stdio.h>
+
+bool StartupProfiler::_enabled = false;
+bool StartupProfiler::_benchmarkMode = false;
+QElapsedTimer StartupProfiler::_timer;
+QList<StartupProfiler::Phase> StartupProfiler::_phases;
+QHash<QString, int> StartupProfiler::_openPhases;
+QHash<QString, StartupProfiler::Sample> StartupProfiler::_samples;
+QStringList StartupProfiler::_sampleOrder;
+QSet<QString> StartupProfiler::_pendingCompletionEvents;
+QSet<QString> StartupProfiler::_marks;
+
+void StartupProfiler::enable(bool benchmarkMode)
+{
+    if (_enabled)
+        return;
+
+    _enabled = true;
+    _benchmarkMode = benchmarkMode;
+    _timer.start();
+    _phases.clear();
+    _openPhases.clear();
+    _samples.clear();
+    _sampleOrder.clear();
+    _marks.clear();
+}
+
+
+void StartupProfiler::setCompletionEvents(const QStringList &events)
+{
+    _pendingCompletionEvents = events.toSet();
+}
+
+
+void StartupProfiler::begin(const QString &phase)
+{
+    if (!_enabled || _openPhases.contains(phase))
+        return;
+
+    _openPhases[phase] = _phases.count();
+    _phases << Phase(phase, _timer.nsecsElapsed());
+}
+
+
+void StartupProfiler::end(const QString &phase)
+{
+    if (!_enabled || !_openPhases.contains(phase))
+        return;
+
+    _phases[_openPhases.take(phase)].end = _timer.nsecsElapsed();
+    eventRecorded(phase);
+}
+
+
+void StartupProfiler::mark(const QString &event)
+{
+    if (!_enabled || _marks.contains(event))
+        return;
+
+    _marks << event;
+    qint64 now = _timer.nsecsElapsed();
+    _phases << Phase(event, now, now);
+    eventRecorded(event);
+}
+
+
+void StartupProfiler::addSample(const QString &operation, qint64 nsecs)
+{
+    if (!_enabled)
+        return;
+
+    if (!_samples.contains(operation))
+        _sampleOrder << operation;
+
+    Sample &sample = _samples[operation];
+    sample.count++;
+    sample.total += nsecs;
+    if (nsecs > sample.max)
+        sample.max = nsecs;
+}
+
+
+void StartupProfiler::eventRecorded(const QString &event)
+{
+    if (!_pendingCompletionEvents.remove(event) || !_pendingCompletionEvents.isEmpty())
+        return;
+
+    finish();
+}
+
+
+void StartupProfiler::finish()
+{
+    if (!_enabled)
+        return;
+
+    QTextStream out(stdout);
+    writeTimeline(out);
+
+    _enabled = false;
+    if (_benchmarkMode)
+        QTimer::singleShot(0, QCoreApplication::instance(), SLOT(quit()));
+}
+
+
+void StartupProfiler::abort()
+{
+    if (!_enabled)
+        return;
+
+    QTextStream out(stdout);
+    out << "Startup did not complete, missing: " << QStringList(_pendingCompletionEvents.toList()).join(", ") << "\n";
+    writeTimeline(out);
+
+    _enabled = false;
+    if (_benchmarkMode)
+        QCoreApplication::exit(1);
+}
+
+
+void StartupProfiler::writeTimeline(QTextStream &out)
+{
+    out << "Startup timeline (milliseconds since start):\n";
+    foreach(const Phase &phase, _phases) {
+        if (phase.start == phase.end) {
+            out << QString("%1            %2\n").arg(phase.start / 1e6, 10, 'f', 1).arg(phase.name);
+        }
+        else if (phase.end < 0) {
+            out << QString("%1 - (unfinished) %2\n").arg(phase.start / 1e6, 10, 'f', 1).arg(phase.name);
+        }
+        else {
+            out << QString("%1 - %2 %3  %4\n").arg(phase.start / 1e6, 10, 'f', 1).arg(phase.end / 1e6, 10, 'f', 1)
+                   .arg(QString("(%1 ms)").arg((phase.end - phase.start) / 1e6, 0, 'f', 1), 13).arg(phase.name);
+        }
+    }
+
+    if (!_sampleOrder.isEmpty()) {
+        out << "Accumulated operations (count, total ms, max ms):\n";
+        foreach(const QString &operation, _sampleOrder) {
+            const Sample &sample = _samples[operation];
+            out << QString("%1 %2 %3  %4\n").arg(sample.count, 8).arg(sample.total / 1e6, 10, 'f', 1).arg(sample.max / 1e6, 10, 'f', 1).arg(operation);
+        }
+    }
+    out.flush();
+}
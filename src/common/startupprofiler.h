@@ -0,0 +1,95 @@
+/***************************************************************************
+ *   Copyright (C) 2005-2015 by the Quassel Project                        *
+ *   devel@quassel-irc.org                                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3.                                           *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.         *
+ ***************************************************************************/
+
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+class QTextStream;
+
+//! Records a timeline of the phases an application goes through while starting up
+/** Profiling is off unless enable() has been called, so the static methods can be sprinkled over
+ *  the startup code paths at negligible cost. Phases are delimited by begin() and end(), single
+ *  points in time are recorded with mark() (only the first occurrence of each), and addSample()
+ *  accumulates durations of recurring operations (such as processing InitData of a certain class).
+ *
+ *  Once all events given to setCompletionEvents() have been recorded, the timeline is written to
+ *  stdout. In benchmark mode, the application quits afterwards. If startup gets stuck, abort()
+ *  writes what has been recorded so far and makes the application exit with an error.
+ */
+class StartupProfiler
+{
+public:
+    static void enable(bool benchmarkMode = false);
+    static inline bool isEnabled() { return _enabled; }
+
+    static void setCompletionEvents(const QStringList &events);
+
+    static void begin(const QString &phase);
+    static void end(const QString &phase);
+    static void mark(const QString &event);
+    static void addSample(const QString &operation, qint64 nsecs);
+
+    //! Returns nanoseconds since profiling was enabled, for use with addSample()
+    static inline qint64 elapsed() { return _enabled ? _timer.nsecsElapsed() : 0; }
+
+    //! Writes the timeline collected so far and stops profiling
+    static void finish();
+
+    //! Like finish(), but also lists the missing completion events; quits with exit code 1 in benchmark mode
+    static void abort();
+
+private:
+    struct Phase {
+        QString name;
+        qint64 start;
+        qint64 end;
+        Phase(const QString &name_ = QString(), qint64 start_ = -1, qint64 end_ = -1) : name(name_), start(start_), end(end_) {}
+    };
+
+    struct Sample {
+        int count;
+        qint64 total;
+        qint64 max;
+        Sample() : count(0), total(0), max(0) {}
+    };
+
+    static void eventRecorded(const QString &event);
+    static void writeTimeline(QTextStream &out);
+
+    static bool _enabled;
+    static bool _benchmarkMode;
+    static QElapsedTimer _timer;
+    static QList<Phase> _phases;
+    static QHash<QString, int> _openPhases;
+    static QHash<QString, Sample> _samples;
+    static QStringList _sampleOrder;
+    static QSet<QString> _pendingCompletionEvents;
+    static QSet<QString> _marks;
+};
+
+
+#endif //STARTUPPROFILER_H
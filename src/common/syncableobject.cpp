@@ -18,7 +18,11 @@
  *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.         *
  ***************************************************************************/
 
+#include <QHash>
+#include <QMetaMethod>
 #include <QMetaProperty>
+#include <QMutex>
+#include <QMutexLocker>
 
 #include <QDebug>
 
@@ -27,6 +31,85 @@
 #include "signalproxy.h"
 #include "util.h"
 
+struct InitGetter {
+    QMetaMethod method;
+    QString name;
+    QVariant::Type type;
+};
+
+struct InitSetter {
+    QMetaMethod method;
+    QByteArray parameterType;
+};
+
+// The reflection data toVariantMap() and fromVariantMap() need for the objects of one class
+struct SerializationTable {
+    QList<QPair<QString, QMetaProperty> > properties;
+    QHash<QString, QMetaProperty> writableProperties;
+    QList<InitGetter> initGetters;
+    QMultiHash<QString, InitSetter> initSetters; // keyed by what follows "initSet"
+};
+
+
+// Builds the table for a class once, so the objects of it are (de)serialized by index rather than by name.
+// Sessions live in threads of their own on the core, hence the mutex.
+static const SerializationTable &serializationTable(const QMetaObject *meta)
+{
+    static QMutex mutex;
+    static QHash<const QMetaObject *, SerializationTable *> tables;
+
+    QMutexLocker locker(&mutex);
+    SerializationTable *&table = tables[meta];
+    if (table)
+        return *table;
+
+    table = new SerializationTable;
+    for (int i = 0; i < meta->propertyCount(); i++) {
+        QMetaProperty prop = meta->property(i);
+        QString propName(prop.name());
+        if (propName == "objectName")
+            continue;
+        table->properties << qMakePair(propName, prop);
+        if (prop.isWritable())
+            table->writableProperties[propName] = prop;
+    }
+
+    for (int i = 0; i < meta->methodCount(); i++) {
+        QMetaMethod method = meta->method(i);
+        QString methodname(SignalProxy::ExtendedMetaObject::methodName(method));
+        if (methodname.startsWith("initSet")) {
+            QList<QByteArray> parameterTypes = method.parameterTypes();
+            if (methodname.length() == 7 || parameterTypes.count() != 1)
+                continue;
+            InitSetter setter;
+            setter.method = method;
+            setter.parameterType = parameterTypes.first();
+            QString propName = methodname.mid(7);
+            propName[0] = propName[0].toUpper();
+            table->initSetters.insert(propName, setter);
+            continue;
+        }
+        if (!methodname.startsWith("init") || methodname.startsWith("initDone"))
+            continue;
+
+        InitGetter getter;
+        getter.method = method;
+        getter.name = SignalProxy::ExtendedMetaObject::methodBaseName(method);
+        getter.type = QVariant::nameToType(method.typeName());
+        if (getter.type == QVariant::Invalid && !QByteArray(method.typeName()).isEmpty()) {
+#if QT_VERSION >= 0x050000
+            qWarning() << "SyncableObject::toVariantMap(): cannot fetch init data for:" << meta->className() << method.methodSignature() << "- Returntype is unknown to Qt's MetaSystem:" << QByteArray(method.typeName());
+#else
+            qWarning() << "SyncableObject::toVariantMap(): cannot fetch init data for:" << meta->className() << method.signature() << "- Returntype is unknown to Qt's MetaSystem:" << QByteArray(method.typeName());
+#endif
+            continue;
+        }
+        table->initGetters << getter;
+    }
+    return *table;
+}
+
+
 INIT_SYNCABLE_OBJECT(SyncableObject)
 SyncableObject::SyncableObject(QObject *parent)
     : QObject(parent),
@@ -92,41 +175,19 @@ QVariantMap SyncableObject::toVariantMap()
 {
     QVariantMap properties;
 
-    const QMetaObject *meta = metaObject();
+    const SerializationTable &table = serializationTable(metaObject());
 
     // we collect data from properties
-    QMetaProperty prop;
-    QString propName;
-    for (int i = 0; i < meta->propertyCount(); i++) {
-        prop = meta->property(i);
-        propName = QString(prop.name());
-        if (propName == "objectName")
-            continue;
-        properties[propName] = prop.read(this);
+    for (int i = 0; i < table.properties.count(); i++) {
+        const QPair<QString, QMetaProperty> &prop = table.properties.at(i);
+        properties[prop.first] = prop.second.read(this);
     }
 
     // ...as well as methods, which have names starting with "init"
-    for (int i = 0; i < meta->methodCount(); i++) {
-        QMetaMethod method = meta->method(i);
-        QString methodname(SignalProxy::ExtendedMetaObject::methodName(method));
-        if (!methodname.startsWith("init") || methodname.startsWith("initSet") || methodname.startsWith("initDone"))
-            continue;
-
-        QVariant::Type variantType = QVariant::nameToType(method.typeName());
-        if (variantType == QVariant::Invalid && !QByteArray(method.typeName()).isEmpty()) {
-#if QT_VERSION >= 0x050000
-            qWarning() << "SyncableObject::toVariantMap(): cannot fetch init data for:" << this << method.methodSignature() << "- Returntype is unknown to Qt's MetaSystem:" << QByteArray(method.typeName());
-#else
-            qWarning() << "SyncableObject::toVariantMap(): cannot fetch init data for:" << this << method.signature() << "- Returntype is unknown to Qt's MetaSystem:" << QByteArray(method.typeName());
-#endif
-            continue;
-        }
-
-        QVariant value(variantType, (const void *)0);
-        QGenericReturnArgument genericvalue = QGenericReturnArgument(method.typeName(), value.data());
-        QMetaObject::invokeMethod(this, methodname.toLatin1(), genericvalue);
-
-        properties[SignalProxy::ExtendedMetaObject::methodBaseName(method)] = value;
+    foreach(const InitGetter &getter, table.initGetters) {
+        QVariant value(getter.type, (const void *)0);
+        getter.method.invoke(this, QGenericReturnArgument(getter.method.typeName(), value.data()));
+        properties[getter.name] = value;
     }
     return properties;
 }
@@ -134,23 +195,21 @@ QVariantMap SyncableObject::toVariantMap()
 
 void SyncableObject::fromVariantMap(const QVariantMap &properties)
 {
-    const QMetaObject *meta = metaObject();
+    const SerializationTable &table = serializationTable(metaObject());
 
     QVariantMap::const_iterator iterator = properties.constBegin();
-    QString propName;
     while (iterator != properties.constEnd()) {
-        propName = iterator.key();
+        const QString &propName = iterator.key();
         if (propName == "objectName") {
             iterator++;
             continue;
         }
 
-        int propertyIndex = meta->indexOfProperty(propName.toLatin1());
-
-        if (propertyIndex == -1 || !meta->property(propertyIndex).isWritable())
+        QHash<QString, QMetaProperty>::const_iterator prop = table.writableProperties.constFind(propName);
+        if (prop == table.writableProperties.constEnd())
             setInitValue(propName, iterator.value());
         else
-            setProperty(propName.toLatin1(), iterator.value());
+            prop.value().write(this, iterator.value());
         // qDebug() << "<<< SYNC:" << name << iterator.value();
         iterator++;
     }
@@ -159,21 +218,21 @@ void SyncableObject::fromVariantMap(const QVariantMap &properties)
 
 bool SyncableObject::setInitValue(const QString &property, const QVariant &value)
 {
-    QString handlername = QString("initSet") + property;
-    handlername[7] = handlername[7].toUpper();
-
-    QString methodSignature = QString("%1(%2)").arg(handlername).arg(value.typeName());
-    int methodIdx = metaObject()->indexOfMethod(methodSignature.toLatin1().constData());
-    if (methodIdx <  0) {
-        QByteArray normedMethodName = QMetaObject::normalizedSignature(methodSignature.toLatin1().constData());
-        methodIdx = metaObject()->indexOfMethod(normedMethodName.constData());
-    }
-    if (methodIdx < 0) {
+    if (property.isEmpty())
         return false;
-    }
 
-    QGenericArgument param(value.typeName(), value.constData());
-    return QMetaObject::invokeMethod(this, handlername.toLatin1(), param);
+    QString propName = property;
+    propName[0] = propName[0].toUpper();
+    QByteArray typeName = QMetaObject::normalizedType(value.typeName());
+
+    const SerializationTable &table = serializationTable(metaObject());
+    QMultiHash<QString, InitSetter>::const_iterator setter = table.initSetters.constFind(propName);
+    while (setter != table.initSetters.constEnd() && setter.key() == propName) {
+        if (setter.value().parameterType == typeName)
+            return setter.value().method.invoke(this, QGenericArgument(value.typeName(), value.constData()));
+        ++setter;
+    }
+    return false;
 }
 
 
@@ -81,6 +81,14 @@ public:
     inline void setAllowClientUpdates(bool allow) { _allowClientUpdates = allow; }
     inline bool allowClientUpdates() const { return _allowClientUpdates; }
 
+    //! Decides whether a sync call should be sent to the given peer
+    /** Objects can override this to keep peers from receiving updates they have no use for.
+     *  The default implementation sends everything to everyone.
+     *  \param peer     The peer the sync call would be dispatched to
+     *  \param slotName The slot that is going to be invoked on the peer's side
+     */
+    virtual bool isSyncedTo(const Peer *peer, const QByteArray &slotName) const { Q_UNUSED(peer); Q_UNUSED(slotName); return true; }
+
 public slots:
     virtual void setInitialized();
     void requestUpdate(const QVariantMap &properties);
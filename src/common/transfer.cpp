@@ -27,6 +27,7 @@ Transfer::Transfer(const QUuid &uuid, QObject *parent)
     _direction(Receive),
     _port(0),
     _fileSize(0),
+    _transferred(0),
     _uuid(uuid)
 {
     init();
@@ -41,6 +42,7 @@ Transfer::Transfer(Direction direction, const QString &nick, const QString &file
     _port(port),
     _fileSize(fileSize),
     _nick(nick),
+    _transferred(0),
     _uuid(QUuid::createUuid())
 {
     init();
@@ -173,6 +175,22 @@ void Transfer::setNick(const QString &nick)
 }
 
 
+quint64 Transfer::transferred() const
+{
+    return _transferred;
+}
+
+
+void Transfer::setTransferred(quint64 transferred)
+{
+    if (_transferred != transferred) {
+        _transferred = transferred;
+        SYNC(ARG(transferred));
+        emit transferredChanged(transferred);
+    }
+}
+
+
 void Transfer::setError(const QString &errorString)
 {
     qWarning() << Q_FUNC_INFO << errorString;
@@ -40,6 +40,7 @@ class Transfer : public SyncableObject
     Q_PROPERTY(QString fileName READ fileName WRITE setFileName NOTIFY fileNameChanged);
     Q_PROPERTY(quint64 fileSize READ fileSize WRITE setFileSize NOTIFY fileSizeChanged);
     Q_PROPERTY(QString nick READ nick WRITE setNick NOTIFY nickChanged);
+    Q_PROPERTY(quint64 transferred READ transferred WRITE setTransferred NOTIFY transferredChanged);
 
 public:
     enum State {
@@ -72,6 +73,8 @@ public:
     quint16 port() const;
     quint64 fileSize() const;
     QString nick() const;
+    //! The number of bytes transferred over the DCC connection so far; updated about once a second
+    quint64 transferred() const;
 
 public slots:
     // called on the client side
@@ -81,6 +84,8 @@ public slots:
     // called on the core side through sync calls
     virtual void requestAccepted(PeerPtr peer) { Q_UNUSED(peer); }
     virtual void requestRejected(PeerPtr peer) { Q_UNUSED(peer); }
+    //! Tells the core how much of the relayed data a client has written (Quassel::TransferFlowControl)
+    virtual void dataAcknowledged(PeerPtr peer, quint64 bytes) { Q_UNUSED(peer); Q_UNUSED(bytes); }
 
 signals:
     void stateChanged(State state);
@@ -90,6 +95,7 @@ signals:
     void fileNameChanged(const QString &fileName);
     void fileSizeChanged(quint64 fileSize);
     void nickChanged(const QString &nick);
+    void transferredChanged(quint64 transferred);
 
     void error(const QString &errorString);
 
@@ -99,20 +105,26 @@ signals:
 protected slots:
     void setState(State state);
     void setError(const QString &errorString);
+    void setTransferred(quint64 transferred);
 
     // called on the client side through sync calls
     virtual void dataReceived(PeerPtr, const QByteArray &data) { Q_UNUSED(data); }
+    //! Tells a client that it can fetch a file stored on the core on the given port (Quassel::StoredTransferConnection)
+    virtual void storedFileReady(PeerPtr, quint16 port, const QByteArray &token) { Q_UNUSED(port); Q_UNUSED(token); }
 
     virtual void cleanUp() = 0;
 
+protected:
+    // only known once the core is listening for or has finished a transfer stored on the core
+    void setPort(quint16 port);
+    void setFileSize(quint64 fileSize);
+
 private:
     void init();
 
     void setDirection(Direction direction);
     void setAddress(const QHostAddress &address);
-    void setPort(quint16 port);
     void setFileName(const QString &fileName);
-    void setFileSize(quint64 fileSize);
     void setNick(const QString &nick);
 
 
@@ -123,6 +135,7 @@ private:
     quint16 _port;
     quint64 _fileSize;
     QString _nick;
+    quint64 _transferred;
     QUuid _uuid;
 };
 
@@ -15,7 +15,35 @@
 #include "cipher.h"
 #include "logger.h"
 
+//Alphabet of the custom base64 variant used by mircryption / FiSH, and its reverse lookup table (-1 for invalid chars)
+const char fishBase64[] = "./0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+const int fishBase64Index[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  0,  1,
+     2,  3,  4,  5,  6,  7,  8,  9, 10, 11, -1, -1, -1, -1, -1, -1,
+    -1, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52,
+    53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63, -1, -1, -1, -1, -1,
+    -1, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26,
+    27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+
 Cipher::Cipher()
+    : m_cbc(false),
+    m_ecbEncoder(0),
+    m_ecbDecoder(0),
+    m_cbcEncoder(0),
+    m_cbcDecoder(0)
 {
     m_primeNum = QCA::BigInteger("12745216229761186769575009943944198619149164746831579719941140425076456621824834322853258804883232842877311723249782818608677050956745409379781245497526069657222703636504651898833151008222772087491045206203033063108075098874712912417029101508315117935752962862335062591404043092163187352352197487303798807791605274487594646923");
     setType("blowfish");
@@ -23,6 +51,11 @@ Cipher::Cipher()
 
 
 Cipher::Cipher(QByteArray key, QString cipherType)
+    : m_cbc(false),
+    m_ecbEncoder(0),
+    m_ecbDecoder(0),
+    m_cbcEncoder(0),
+    m_cbcDecoder(0)
 {
     m_primeNum = QCA::BigInteger("12745216229761186769575009943944198619149164746831579719941140425076456621824834322853258804883232842877311723249782818608677050956745409379781245497526069657222703636504651898833151008222772087491045206203033063108075098874712912417029101508315117935752962862335062591404043092163187352352197487303798807791605274487594646923");
     setKey(key);
@@ -31,10 +64,14 @@ Cipher::Cipher(QByteArray key, QString cipherType)
 
 
 Cipher::~Cipher()
-{}
+{
+    resetCipherContexts();
+}
 
 bool Cipher::setKey(QByteArray key)
 {
+    resetCipherContexts();
+
     if (key.isEmpty()) {
         m_key.clear();
         return false;
@@ -66,11 +103,38 @@ bool Cipher::setKey(QByteArray key)
 bool Cipher::setType(const QString &type)
 {
     //TODO check QCA::isSupported()
+    if (m_type != type)
+        resetCipherContexts();
     m_type = type;
     return true;
 }
 
 
+QCA::Cipher *Cipher::cipherContext(QCA::Cipher::Mode mode, bool direction)
+{
+    QCA::Cipher *&context = (mode == QCA::Cipher::CBC) ? (direction ? m_cbcEncoder : m_cbcDecoder)
+                                                       : (direction ? m_ecbEncoder : m_ecbDecoder);
+    if (!context) {
+        QCA::Direction dir = (direction) ? QCA::Encode : QCA::Decode;
+        if (mode == QCA::Cipher::CBC)
+            context = new QCA::Cipher(m_type, QCA::Cipher::CBC, QCA::Cipher::NoPadding, dir, m_key, QCA::InitializationVector(QByteArray("0")));
+        else
+            context = new QCA::Cipher(m_type, QCA::Cipher::ECB, QCA::Cipher::NoPadding, dir, m_key);
+    }
+    return context;
+}
+
+
+void Cipher::resetCipherContexts()
+{
+    delete m_ecbEncoder;
+    delete m_ecbDecoder;
+    delete m_cbcEncoder;
+    delete m_cbcDecoder;
+    m_ecbEncoder = m_ecbDecoder = m_cbcEncoder = m_cbcDecoder = 0;
+}
+
+
 QByteArray Cipher::decrypt(QByteArray cipherText)
 {
     QByteArray pfx = "";
@@ -316,7 +380,6 @@ bool Cipher::encrypt(QByteArray &cipherText)
 //THE BELOW WORKS AKA DO NOT TOUCH UNLESS YOU KNOW WHAT YOU'RE DOING
 QByteArray Cipher::blowfishCBC(QByteArray cipherText, bool direction)
 {
-    QCA::Initializer init;
     QByteArray temp = cipherText;
     if (direction)
     {
@@ -335,12 +398,13 @@ QByteArray Cipher::blowfishCBC(QByteArray cipherText, bool direction)
         while ((temp.length() % 8) != 0) temp.append('\0');
     }
 
-    QCA::Direction dir = (direction) ? QCA::Encode : QCA::Decode;
-    QCA::Cipher cipher(m_type, QCA::Cipher::CBC, QCA::Cipher::NoPadding, dir, m_key, QCA::InitializationVector(QByteArray("0")));
-    QByteArray temp2 = cipher.update(QCA::MemoryRegion(temp)).toByteArray();
-    temp2 += cipher.final().toByteArray();
+    QCA::Cipher *cipher = cipherContext(QCA::Cipher::CBC, direction);
+    QByteArray temp2 = cipher->update(QCA::MemoryRegion(temp)).toByteArray();
+    temp2 += cipher->final().toByteArray();
+    bool ok = cipher->ok();
+    cipher->clear(); // restart the chain from the IV for the next message
 
-    if (!cipher.ok())
+    if (!ok)
         return cipherText;
 
     if (direction) //send in base64
@@ -354,7 +418,6 @@ QByteArray Cipher::blowfishCBC(QByteArray cipherText, bool direction)
 
 QByteArray Cipher::blowfishECB(QByteArray cipherText, bool direction)
 {
-    QCA::Initializer init;
     QByteArray temp = cipherText;
 
     //do padding ourselves
@@ -372,13 +435,22 @@ QByteArray Cipher::blowfishECB(QByteArray cipherText, bool direction)
         while ((temp.length() % 8) != 0) temp.append('\0');
     }
 
-    QCA::Direction dir = (direction) ? QCA::Encode : QCA::Decode;
-    QCA::Cipher cipher(m_type, QCA::Cipher::ECB, QCA::Cipher::NoPadding, dir, m_key);
-    QByteArray temp2 = cipher.update(QCA::MemoryRegion(temp)).toByteArray();
-    temp2 += cipher.final().toByteArray();
+    // ECB keeps no state between blocks and we always feed whole blocks, so the context can
+    // normally be reused as is without finalizing it
+    QCA::Cipher *cipher = cipherContext(QCA::Cipher::ECB, direction);
+    QByteArray temp2 = cipher->update(QCA::MemoryRegion(temp)).toByteArray();
+    bool ok = cipher->ok();
+    if (ok && temp2.length() != temp.length()) {
+        // the provider held back some data after all
+        temp2 += cipher->final().toByteArray();
+        ok = cipher->ok();
+        cipher->clear();
+    }
 
-    if (!cipher.ok())
+    if (!ok) {
+        resetCipherContexts();
         return cipherText;
+    }
 
     if (direction) {
         // Sanity check
@@ -393,49 +465,27 @@ QByteArray Cipher::blowfishECB(QByteArray cipherText, bool direction)
 
 
 //Custom non RFC 2045 compliant Base64 enc/dec code for mircryption / FiSH compatibility
+//Every 8 byte block is encoded as two big endian 32 bit words, each one written as 6 chars starting
+//with the least significant bits, right word first. Note that the words are shifted as signed ints,
+//so the last char of a word with the top bit set carries the sign bits; decoding ignores those.
 QByteArray Cipher::byteToB64(QByteArray text)
 {
-    int left = 0;
-    int right = 0;
-    int k = -1;
-    int v;
-    QString base64 = "./0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    const uchar *data = reinterpret_cast<const uchar *>(text.constData());
+    int blocks = text.length() / 8;
     QByteArray encoded;
-    while (k < (text.length() - 1)) {
-        k++;
-        v = text.at(k); if (v < 0) v += 256;
-        left = v << 24;
-        k++;
-        v = text.at(k); if (v < 0) v += 256;
-        left += v << 16;
-        k++;
-        v = text.at(k); if (v < 0) v += 256;
-        left += v << 8;
-        k++;
-        v = text.at(k); if (v < 0) v += 256;
-        left += v;
-
-        k++;
-        v = text.at(k); if (v < 0) v += 256;
-        right = v << 24;
-        k++;
-        v = text.at(k); if (v < 0) v += 256;
-        right += v << 16;
-        k++;
-        v = text.at(k); if (v < 0) v += 256;
-        right += v << 8;
-        k++;
-        v = text.at(k); if (v < 0) v += 256;
-        right += v;
+    encoded.resize(blocks * 12);
+    char *out = encoded.data();
+
+    for (int b = 0; b < blocks; b++, data += 8) {
+        qint32 left = (qint32)((quint32)data[0] << 24 | (quint32)data[1] << 16 | (quint32)data[2] << 8 | data[3]);
+        qint32 right = (qint32)((quint32)data[4] << 24 | (quint32)data[5] << 16 | (quint32)data[6] << 8 | data[7]);
 
         for (int i = 0; i < 6; i++) {
-            encoded.append(base64.at(right & 0x3F).toLatin1());
+            *out++ = fishBase64[right & 0x3F];
             right = right >> 6;
         }
-
-        //TODO make sure the .toLatin1 doesn't break anything
         for (int i = 0; i < 6; i++) {
-            encoded.append(base64.at(left & 0x3F).toLatin1());
+            *out++ = fishBase64[left & 0x3F];
             left = left >> 6;
         }
     }
@@ -445,41 +495,26 @@ QByteArray Cipher::byteToB64(QByteArray text)
 
 QByteArray Cipher::b64ToByte(QByteArray text)
 {
-    QString base64 = "./0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    const uchar *data = reinterpret_cast<const uchar *>(text.constData());
+    int blocks = text.length() / 12;
     QByteArray decoded;
-    int k = -1;
-    while (k < (text.length() - 1)) {
-        int right = 0;
-        int left = 0;
-        int v = 0;
-        int w = 0;
-        int z = 0;
-
-        for (int i = 0; i < 6; i++) {
-            k++;
-            v = base64.indexOf(text.at(k));
-            right |= v << (i * 6);
-        }
-
-        for (int i = 0; i < 6; i++) {
-            k++;
-            v = base64.indexOf(text.at(k));
-            left |= v << (i * 6);
-        }
-
-        for (int i = 0; i < 4; i++) {
-            w = ((left & (0xFF << ((3 - i) * 8))));
-            z = w >> ((3 - i) * 8);
-            if (z < 0) { z = z + 256; }
-            decoded.append(z);
-        }
-
-        for (int i = 0; i < 4; i++) {
-            w = ((right & (0xFF << ((3 - i) * 8))));
-            z = w >> ((3 - i) * 8);
-            if (z < 0) { z = z + 256; }
-            decoded.append(z);
-        }
+    decoded.resize(blocks * 8);
+    char *out = decoded.data();
+
+    for (int b = 0; b < blocks; b++, data += 12) {
+        quint32 right = 0;
+        quint32 left = 0;
+
+        // invalid chars map to -1, which sets all higher bits just like the original implementation did
+        for (int i = 0; i < 6; i++)
+            right |= (quint32)fishBase64Index[data[i]] << (i * 6);
+        for (int i = 0; i < 6; i++)
+            left |= (quint32)fishBase64Index[data[6 + i]] << (i * 6);
+
+        for (int i = 0; i < 4; i++)
+            *out++ = (char)(left >> ((3 - i) * 8));
+        for (int i = 0; i < 4; i++)
+            *out++ = (char)(right >> ((3 - i) * 8));
     }
     return decoded;
 }
@@ -487,10 +522,11 @@ QByteArray Cipher::b64ToByte(QByteArray text)
 
 bool Cipher::neededFeaturesAvailable()
 {
-    QCA::Initializer init;
-
-    if (QCA::isSupported("blowfish-ecb") && QCA::isSupported("blowfish-cbc") && QCA::isSupported("dh"))
-        return true;
+    // this is checked for every encrypted message, and the set of available providers doesn't change at runtime
+    static const bool available = []() {
+        QCA::Initializer init;
+        return QCA::isSupported("blowfish-ecb") && QCA::isSupported("blowfish-cbc") && QCA::isSupported("dh");
+    }();
 
-    return false;
+    return available;
 }
@@ -37,18 +37,28 @@ public:
     inline bool usesCBC() { return m_cbc; }
 
 private:
+    Q_DISABLE_COPY(Cipher)
+
     //direction is true for encrypt, false for decrypt
     QByteArray blowfishCBC(QByteArray cipherText, bool direction);
     QByteArray blowfishECB(QByteArray cipherText, bool direction);
     QByteArray b64ToByte(QByteArray text);
     QByteArray byteToB64(QByteArray text);
 
+    //cipher contexts are expensive to set up, so we keep them around until key or type change
+    QCA::Cipher *cipherContext(QCA::Cipher::Mode mode, bool direction);
+    void resetCipherContexts();
+
     QCA::Initializer init;
     QByteArray m_key;
     QCA::DHPrivateKey m_tempKey;
     QCA::BigInteger m_primeNum;
     QString m_type;
     bool m_cbc;
+    QCA::Cipher *m_ecbEncoder;
+    QCA::Cipher *m_ecbDecoder;
+    QCA::Cipher *m_cbcEncoder;
+    QCA::Cipher *m_cbcDecoder;
 };
 
 
@@ -621,6 +621,7 @@ void Core::setupInternalClientSession(InternalPeer *clientPeer)
     }
 
     InternalPeer *corePeer = new InternalPeer(this);
+    corePeer->setFeatures(Quassel::features());
     corePeer->setPeer(clientPeer);
     clientPeer->setPeer(corePeer);
 
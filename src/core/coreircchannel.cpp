@@ -19,7 +19,9 @@
  ***************************************************************************/
 
 #include "coreircchannel.h"
+#include "coreircuser.h"
 #include "corenetwork.h"
+#include "coresession.h"
 
 INIT_SYNCABLE_OBJECT(CoreIrcChannel)
 CoreIrcChannel::CoreIrcChannel(const QString &channelname, Network *network)
@@ -29,6 +31,8 @@ CoreIrcChannel::CoreIrcChannel(const QString &channelname, Network *network)
 #ifdef HAVE_QCA2
     _cipher = 0;
 #endif
+
+    connect(this, SIGNAL(ircUsersJoined(QList<IrcUser *>)), SLOT(catchUpJoinedUsers(QList<IrcUser *>)));
 }
 
 
@@ -40,6 +44,63 @@ CoreIrcChannel::~CoreIrcChannel()
 }
 
 
+bool CoreIrcChannel::isSyncedTo(const Peer *peer, const QByteArray &slotName) const
+{
+    if (slotName == "changeModes")
+        return peer->features().testFlag(Quassel::BatchedModeChanges);
+
+    if (slotName != "updateIrcUsers")
+        return true;
+
+    // older clients, and clients not showing this channel, get individual IrcUser updates
+    // instead, see CoreNetwork::flushWhoDetails()
+    if (!peer->features().testFlag(Quassel::BatchedUserDetails))
+        return false;
+
+    CoreNetwork *net = qobject_cast<CoreNetwork *>(network());
+    return !net || net->coreSession()->isSyncInterested(peer, this);
+}
+
+
+void CoreIrcChannel::catchUpJoinedUsers(const QList<IrcUser *> &ircUsers)
+{
+    foreach(IrcUser *ircUser, ircUsers) {
+        CoreIrcUser *coreIrcUser = qobject_cast<CoreIrcUser *>(ircUser);
+        if (coreIrcUser)
+            coreIrcUser->catchUp();
+    }
+}
+
+
+void CoreIrcChannel::applyModeLine(const QString &modes, const QStringList &values)
+{
+    if (values.isEmpty())
+        return;
+
+    changeModes(modes, values);
+
+    CoreNetwork *net = qobject_cast<CoreNetwork *>(network());
+    if (!net)
+        return;
+
+    const QString prefixModes = net->prefixModes();
+    SignalProxy *proxy = net->coreSession()->signalProxy();
+    foreach(Peer *peer, proxy->peers()) {
+        if (peer->features().testFlag(Quassel::BatchedModeChanges))
+            continue;
+
+        for (int i = 0; i < values.count(); i++) {
+            bool add = (modes[2 * i] == '+');
+            QChar mode = modes[2 * i + 1];
+            if (prefixModes.contains(mode))
+                proxy->sendSync(peer, this, add ? "addUserMode" : "removeUserMode", QVariantList() << values[i] << QString(mode));
+            else
+                proxy->sendSync(peer, this, add ? "addChannelMode" : "removeChannelMode", QVariantList() << QVariant(mode) << values[i]);
+        }
+    }
+}
+
+
 #ifdef HAVE_QCA2
 Cipher *CoreIrcChannel::cipher() const
 {
@@ -38,6 +38,17 @@ public:
 
     inline virtual const QMetaObject *syncMetaObject() const { return &IrcChannel::staticMetaObject; }
 
+    virtual bool isSyncedTo(const Peer *peer, const QByteArray &slotName) const;
+
+    //! Applies a whole MODE line, see IrcChannel::changeModes()
+    /** Clients without Quassel::BatchedModeChanges get the individual changes instead.
+     */
+    void applyModeLine(const QString &modes, const QStringList &values);
+
+private slots:
+    //! Sends joining users' details to clients that missed them while not showing any of the users' buffers
+    void catchUpJoinedUsers(const QList<IrcUser *> &ircUsers);
+
 #ifdef HAVE_QCA2
     Cipher *cipher() const;
     void setEncrypted(bool);
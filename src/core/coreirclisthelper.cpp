@@ -23,11 +23,13 @@
 #include "corenetwork.h"
 #include "coreuserinputhandler.h"
 
+const int channelListPageSize = 500; // entries per reply to requestChannelListPage()
+
 INIT_SYNCABLE_OBJECT(CoreIrcListHelper)
 QVariantList CoreIrcListHelper::requestChannelList(const NetworkId &netId, const QStringList &channelFilters)
 {
     if (_finishedChannelLists.contains(netId))
-        return _finishedChannelLists.take(netId);
+        return channelListPage(_finishedChannelLists.take(netId), 0, -1);
 
     if (_channelLists.contains(netId)) {
         _queuedQuery[netId] = channelFilters.join(",");
@@ -39,6 +41,49 @@ QVariantList CoreIrcListHelper::requestChannelList(const NetworkId &netId, const
 }
 
 
+QVariantList CoreIrcListHelper::requestChannelListPage(const NetworkId &netId, int offset)
+{
+    // a new query is about to be dispatched, whatever we have collected so far is stale
+    if (_queuedQuery.contains(netId))
+        return QVariantList();
+
+    if (_channelLists.contains(netId))
+        return channelListPage(_channelLists[netId], offset, channelListPageSize);
+
+    if (_finishedChannelLists.contains(netId)) {
+        QVariantList page = channelListPage(_finishedChannelLists[netId], offset, channelListPageSize);
+        // once the last page has been handed out there's no need to keep the list around
+        if (offset + page.count() >= _finishedChannelLists[netId].count())
+            _finishedChannelLists.remove(netId);
+        return page;
+    }
+
+    return QVariantList();
+}
+
+
+QVariantList CoreIrcListHelper::channelListPage(const QList<ChannelDescription> &channels, int offset, int maxCount)
+{
+    QVariantList channelList;
+    if (offset < 0 || offset >= channels.count())
+        return channelList;
+
+    int end = channels.count();
+    if (maxCount >= 0 && offset + maxCount < end)
+        end = offset + maxCount;
+
+    for (int i = offset; i < end; i++) {
+        const ChannelDescription &channel = channels.at(i);
+        QVariantList channelVariant;
+        channelVariant << channel.channelName
+                       << channel.userCount
+                       << channel.topic;
+        channelList << qVariantFromValue<QVariant>(channelVariant);
+    }
+    return channelList;
+}
+
+
 bool CoreIrcListHelper::addChannel(const NetworkId &netId, const QString &channelName, quint32 userCount, const QString &topic)
 {
     if (!_channelLists.contains(netId))
@@ -71,16 +116,7 @@ bool CoreIrcListHelper::endOfChannelList(const NetworkId &netId)
         return dispatchQuery(netId, _queuedQuery.take(netId));
     }
     else if (_channelLists.contains(netId)) {
-        QVariantList channelList;
-        foreach(ChannelDescription channel, _channelLists[netId]) {
-            QVariantList channelVariant;
-            channelVariant << channel.channelName
-                           << channel.userCount
-                           << channel.topic;
-            channelList << qVariantFromValue<QVariant>(channelVariant);
-        }
-        _finishedChannelLists[netId] = channelList;
-        _channelLists.remove(netId);
+        _finishedChannelLists[netId] = _channelLists.take(netId);
         reportFinishedList(netId);
         return true;
     }
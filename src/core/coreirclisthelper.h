@@ -43,6 +43,7 @@ public:
 
 public slots:
     virtual QVariantList requestChannelList(const NetworkId &netId, const QStringList &channelFilters);
+    virtual QVariantList requestChannelListPage(const NetworkId &netId, int offset);
     bool addChannel(const NetworkId &netId, const QString &channelName, quint32 userCount, const QString &topic);
     bool endOfChannelList(const NetworkId &netId);
 
@@ -51,13 +52,14 @@ protected:
 
 private:
     bool dispatchQuery(const NetworkId &netId, const QString &query);
+    static QVariantList channelListPage(const QList<ChannelDescription> &channels, int offset, int maxCount);
 
 private:
     CoreSession *_coreSession;
 
     QHash<NetworkId, QString> _queuedQuery;
     QHash<NetworkId, QList<ChannelDescription> > _channelLists;
-    QHash<NetworkId, QVariantList> _finishedChannelLists;
+    QHash<NetworkId, QList<ChannelDescription> > _finishedChannelLists;
     QHash<int, NetworkId> _queryTimeout;
 };
 
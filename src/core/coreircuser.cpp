@@ -19,6 +19,18 @@
  ***************************************************************************/
 
 #include "coreircuser.h"
+#include "corenetwork.h"
+#include "coresession.h"
+#include "signalproxy.h"
+
+// Details only shown in nick lists and tooltips; clients that don't show any buffer this user
+// is in can live without them. Structural changes (nick, modes, channels) are always synced.
+// update() is only used for batches of WHO details (see IrcUser::syncDetails()).
+static const char *detailSlots[] = {
+    "update", "setUser", "setHost", "setRealName", "setAway", "setAwayMessage", "setIdleTime", "setLoginTime",
+    "setServer", "setIrcOperator", "setLastAwayMessage", "setWhoisServiceReply", "setSuserHost", 0
+};
+
 
 CoreIrcUser::CoreIrcUser(const QString &hostmask, Network *network) : IrcUser(hostmask, network)
 {
@@ -36,6 +48,56 @@ CoreIrcUser::~CoreIrcUser()
 }
 
 
+bool CoreIrcUser::isSyncedTo(const Peer *peer, const QByteArray &slotName) const
+{
+    bool isDetail = false;
+    for (int i = 0; detailSlots[i] && !isDetail; i++)
+        isDetail = (slotName == detailSlots[i]);
+
+    if (!isDetail || this == network()->me())
+        return true;
+
+    CoreNetwork *net = qobject_cast<CoreNetwork *>(network());
+    if (!net || net->coreSession()->isSyncInterested(peer, this))
+        return true;
+
+    setOutdatedFor(peer);
+    return false;
+}
+
+
+void CoreIrcUser::catchUp(Peer *peer)
+{
+    CoreNetwork *net = qobject_cast<CoreNetwork *>(network());
+    if (!net || !_outdatedPeers.contains(peer) || !net->coreSession()->isSyncInterested(peer, this))
+        return;
+
+    _outdatedPeers.remove(peer);
+    net->coreSession()->signalProxy()->sendUpdate(peer, this);
+}
+
+
+void CoreIrcUser::catchUp()
+{
+    if (_outdatedPeers.isEmpty())
+        return;
+
+    CoreNetwork *net = qobject_cast<CoreNetwork *>(network());
+    if (!net)
+        return;
+
+    // forget peers that have disconnected in the meantime
+    const QSet<Peer *> &peers = net->coreSession()->signalProxy()->peers();
+    foreach(const Peer *peer, _outdatedPeers) {
+        if (!peers.contains(const_cast<Peer *>(peer)))
+            _outdatedPeers.remove(peer);
+    }
+
+    foreach(Peer *peer, peers)
+        catchUp(peer);
+}
+
+
 #ifdef HAVE_QCA2
 Cipher *CoreIrcUser::cipher() const
 {
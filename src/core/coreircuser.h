@@ -21,6 +21,8 @@
 #ifndef COREIRCUSER_H_
 #define COREIRCUSER_H_
 
+#include <QSet>
+
 #include "ircuser.h"
 
 #ifdef HAVE_QCA2
@@ -38,12 +40,25 @@ public:
 
     inline virtual const QMetaObject *syncMetaObject() const { return &IrcUser::staticMetaObject; }
 
+    virtual bool isSyncedTo(const Peer *peer, const QByteArray &slotName) const;
+
+    //! Remembers that the peer missed some of our details, because it wasn't interested in us
+    inline void setOutdatedFor(const Peer *peer) const { _outdatedPeers.insert(peer); }
+
+    //! Sends our full state to the peer if it missed details and is interested in us now
+    void catchUp(Peer *peer);
+
+    //! Calls catchUp() for every connected peer that missed details
+    void catchUp();
+
 #ifdef HAVE_QCA2
     Cipher *cipher() const;
 #endif
 
-#ifdef HAVE_QCA2
 private:
+    mutable QSet<const Peer *> _outdatedPeers;
+
+#ifdef HAVE_QCA2
     mutable Cipher *_cipher;
 #endif
 };
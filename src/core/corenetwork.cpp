@@ -308,6 +308,7 @@ void CoreNetwork::setChannelParted(const QString &channel)
     removeChannelKey(channel);
     _autoWhoQueue.removeAll(channel.toLower());
     _autoWhoPending.remove(channel.toLower());
+    _whoDetails.remove(channel.toLower());
 
     Core::setChannelPersistent(userId(), networkId(), channel, false);
 }
@@ -410,6 +411,66 @@ bool CoreNetwork::setAutoWhoDone(const QString &channel)
 }
 
 
+void CoreNetwork::addWhoDetails(const QString &channel, const QString &nick, const QVariantMap &details)
+{
+    if (details.isEmpty())
+        return;
+
+    QVariantMap &channelDetails = _whoDetails[channel.toLower()];
+    QVariantMap userDetails = channelDetails.value(nick).toMap();
+    QVariantMap::const_iterator iter = details.constBegin();
+    while (iter != details.constEnd()) {
+        userDetails[iter.key()] = iter.value();
+        ++iter;
+    }
+    channelDetails[nick] = userDetails;
+}
+
+
+void CoreNetwork::flushWhoDetails(const QString &channel)
+{
+    QVariantMap pending = _whoDetails.take(channel.toLower());
+    IrcChannel *chan = ircChannel(channel);
+    if (pending.isEmpty() || !chan)
+        return;
+
+    // users may have changed (or left) since their WHO line came in, so send what we know now
+    QVariantMap details;
+    QHash<IrcUser *, QVariantMap> userDetails;
+    QVariantMap::const_iterator iter = pending.constBegin();
+    while (iter != pending.constEnd()) {
+        IrcUser *ircuser = ircUser(iter.key());
+        if (ircuser) {
+            QVariantMap current;
+            foreach(const QString &key, iter.value().toMap().keys())
+                current[key] = ircuser->property(key.toLatin1());
+            details[ircuser->nick()] = current;
+            userDetails[ircuser] = current;
+        }
+        ++iter;
+    }
+
+    // goes to clients supporting Quassel::BatchedUserDetails that show the channel, see CoreIrcChannel::isSyncedTo()
+    chan->updateIrcUsers(details);
+
+    // everyone else gets the users they are interested in through another buffer, if any
+    SignalProxy *proxy = coreSession()->signalProxy();
+    foreach(Peer *peer, proxy->peers()) {
+        if (peer->features().testFlag(Quassel::BatchedUserDetails) && coreSession()->isSyncInterested(peer, chan))
+            continue;
+
+        QHash<IrcUser *, QVariantMap>::const_iterator userIter = userDetails.constBegin();
+        while (userIter != userDetails.constEnd()) {
+            if (coreSession()->isSyncInterested(peer, userIter.key()))
+                proxy->sendUpdate(peer, userIter.key(), userIter.value());
+            else if (CoreIrcUser *coreIrcUser = qobject_cast<CoreIrcUser *>(userIter.key()))
+                coreIrcUser->setOutdatedFor(peer);
+            ++userIter;
+        }
+    }
+}
+
+
 void CoreNetwork::setMyNick(const QString &mynick)
 {
     Network::setMyNick(mynick);
@@ -503,6 +564,7 @@ void CoreNetwork::socketDisconnected()
     _autoWhoTimer.stop();
     _autoWhoQueue.clear();
     _autoWhoPending.clear();
+    _whoDetails.clear();
 
     _socketCloseTimer.stop();
 
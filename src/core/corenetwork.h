@@ -95,6 +95,10 @@ public:
     inline quint16 localPort() const { return socket.localPort(); }
     inline quint16 peerPort() const { return socket.peerPort(); }
 
+    //! The number of lines held back by flood protection, and the delay in ms between sending two of them
+    inline int sendQueueLength() const { return _msgQueue.count(); }
+    inline int messageDelay() const { return _messageDelay; }
+
     QList<QList<QByteArray>> splitMessage(const QString &cmd, const QString &message, std::function<QList<QByteArray>(QString &)> cmdGenerator);
 
 public slots:
@@ -137,6 +141,13 @@ public slots:
 
     bool setAutoWhoDone(const QString &channel);
 
+    //! Remembers the details a channel's auto-WHO reply changed for one of its members
+    /** The core's own state is up to date already; the clients get all of a channel's changes at once
+     *  when the reply ends, see flushWhoDetails().
+     */
+    void addWhoDetails(const QString &channel, const QString &nick, const QVariantMap &details);
+    void flushWhoDetails(const QString &channel);
+
     void updateIssuedModes(const QString &requestedModes);
     void updatePersistentModes(QString addModes, QString removeModes);
     void resetPersistentModes();
@@ -236,6 +247,7 @@ private:
 
     QStringList _autoWhoQueue;
     QHash<QString, int> _autoWhoPending;
+    QHash<QString, QVariantMap> _whoDetails; // channel -> nick -> changed details
     QTimer _autoWhoTimer, _autoWhoCycleTimer;
 
     QTimer _tokenBucketTimer;
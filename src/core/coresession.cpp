@@ -20,6 +20,7 @@
 
 #include "coresession.h"
 
+#include <QDir>
 #include <QtScript>
 
 #include "core.h"
@@ -44,6 +45,7 @@
 #include "ircuser.h"
 #include "logger.h"
 #include "messageevent.h"
+#include "quassel.h"
 #include "remotepeer.h"
 #include "storage.h"
 #include "util.h"
@@ -102,6 +104,14 @@ CoreSession::CoreSession(UserId uid, bool restoreState, QObject *parent)
 
     p->attachSlot(SIGNAL(changePassword(PeerPtr,QString,QString,QString)), this, SLOT(changePassword(PeerPtr,QString,QString,QString)));
     p->attachSignal(this, SIGNAL(passwordChanged(PeerPtr,bool)));
+    p->attachSlot(SIGNAL(setSyncInterest(PeerPtr,QVariantList)), this, SLOT(setSyncInterest(PeerPtr,QVariantList)));
+
+    // keep files received via DCC on the core, in a directory of each user's own
+    if (Quassel::isOptionSet("dcc-dir")) {
+        _transferManager->setStorageDir(QDir(Quassel::optionValue("dcc-dir")).absoluteFilePath(QString::number(user().toInt())));
+        _transferManager->setStorageLimits(Quassel::optionValue("dcc-max-size").toULongLong() * 1024 * 1024,
+            Quassel::optionValue("dcc-quota").toULongLong() * 1024 * 1024);
+    }
 
     loadSettings();
     initScriptEngine();
@@ -228,12 +238,95 @@ void CoreSession::addClient(InternalPeer *peer)
 
 void CoreSession::removeClient(Peer *peer)
 {
+    _syncInterest.remove(peer);
+
     RemotePeer *p = qobject_cast<RemotePeer *>(peer);
     if (p)
         quInfo() << qPrintable(tr("Client")) << p->description() << qPrintable(tr("disconnected (UserId: %1).").arg(user().toInt()));
 }
 
 
+// buffer names in an interest set are stored lowercase
+static bool coversIrcUser(const QSet<QString> &bufferNames, const IrcUser *ircUser)
+{
+    if (bufferNames.contains(ircUser->nick().toLower()))
+        return true;
+
+    foreach(const QString &channel, ircUser->channels()) {
+        if (bufferNames.contains(channel.toLower()))
+            return true;
+    }
+    return false;
+}
+
+
+bool CoreSession::isSyncInterested(const Peer *peer, const IrcUser *ircUser) const
+{
+    QHash<const Peer *, QHash<NetworkId, QSet<QString> > >::const_iterator interest = _syncInterest.constFind(peer);
+    if (interest == _syncInterest.constEnd())
+        return true;
+
+    QHash<NetworkId, QSet<QString> >::const_iterator bufferNames = interest->constFind(ircUser->network()->networkId());
+    return bufferNames != interest->constEnd() && coversIrcUser(*bufferNames, ircUser);
+}
+
+
+bool CoreSession::isSyncInterested(const Peer *peer, const IrcChannel *ircChannel) const
+{
+    QHash<const Peer *, QHash<NetworkId, QSet<QString> > >::const_iterator interest = _syncInterest.constFind(peer);
+    if (interest == _syncInterest.constEnd())
+        return true;
+
+    QHash<NetworkId, QSet<QString> >::const_iterator bufferNames = interest->constFind(ircChannel->network()->networkId());
+    return bufferNames != interest->constEnd() && bufferNames->contains(ircChannel->name().toLower());
+}
+
+
+void CoreSession::setSyncInterest(PeerPtr peer, const QVariantList &buffers)
+{
+    QHash<NetworkId, QSet<QString> > interest;
+    foreach(const QVariant &buffer, buffers) {
+        BufferInfo bufferInfo = buffer.value<BufferInfo>();
+        if (bufferInfo.type() == BufferInfo::ChannelBuffer || bufferInfo.type() == BufferInfo::QueryBuffer)
+            interest[bufferInfo.networkId()].insert(bufferInfo.bufferName().toLower());
+    }
+
+    bool hadInterest = _syncInterest.contains(peer);
+    QHash<NetworkId, QSet<QString> > previous = _syncInterest.value(peer);
+    _syncInterest[peer] = interest;
+
+    // Before its first declaration the peer received everything, so there is nothing to catch up on.
+    // Otherwise, users that just became interesting may have changed while they were filtered out.
+    if (!hadInterest)
+        return;
+
+    QHash<NetworkId, QSet<QString> >::const_iterator netIter = interest.constBegin();
+    while (netIter != interest.constEnd()) {
+        CoreNetwork *net = network(netIter.key());
+        const QSet<QString> &oldNames = previous[netIter.key()];
+        if (net) {
+            foreach(const QString &bufferName, *netIter) {
+                if (oldNames.contains(bufferName))
+                    continue;
+
+                QList<IrcUser *> ircUsers;
+                if (IrcChannel *channel = net->ircChannel(bufferName))
+                    ircUsers = channel->ircUsers();
+                else if (IrcUser *ircUser = net->ircUser(bufferName))
+                    ircUsers << ircUser;
+
+                foreach(IrcUser *ircUser, ircUsers) {
+                    CoreIrcUser *coreIrcUser = qobject_cast<CoreIrcUser *>(ircUser);
+                    if (coreIrcUser)
+                        coreIrcUser->catchUp(peer);
+                }
+            }
+        }
+        ++netIter;
+    }
+}
+
+
 QHash<QString, QString> CoreSession::persistentChannels(NetworkId id) const
 {
     return Core::persistentChannels(user(), id);
@@ -567,6 +660,16 @@ void CoreSession::renameBuffer(const NetworkId &networkId, const QString &newNam
     if (bufferInfo.isValid()) {
         _bufferSyncer->renameBuffer(bufferInfo.bufferId(), newName);
     }
+
+    // keep the query covered in the interest sets of clients showing it
+    QString oldKey = oldName.toLower();
+    QHash<const Peer *, QHash<NetworkId, QSet<QString> > >::iterator interest = _syncInterest.begin();
+    while (interest != _syncInterest.end()) {
+        QHash<NetworkId, QSet<QString> >::iterator bufferNames = interest->find(networkId);
+        if (bufferNames != interest->end() && bufferNames->remove(oldKey))
+            bufferNames->insert(newName.toLower());
+        ++interest;
+    }
 }
 
 
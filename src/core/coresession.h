@@ -21,6 +21,7 @@
 #ifndef CORESESSION_H
 #define CORESESSION_H
 
+#include <QSet>
 #include <QString>
 #include <QVariant>
 
@@ -45,7 +46,9 @@ class CtcpParser;
 class EventManager;
 class EventStringifier;
 class InternalPeer;
+class IrcChannel;
 class IrcParser;
+class IrcUser;
 class MessageEvent;
 class NetworkConnection;
 class RemotePeer;
@@ -93,6 +96,16 @@ public:
     //! Return necessary data for restoring the session after restarting the core
     void restoreSessionState();
 
+    //! Checks whether the given peer wants detailed updates for the given user
+    /** Clients may declare the buffers they actually show (see setSyncInterest()). Users that are in none
+     *  of these, neither as a channel member nor as a query, don't need their details synced to that client.
+     *  Peers that never declared an interest get everything.
+     */
+    bool isSyncInterested(const Peer *peer, const IrcUser *ircUser) const;
+
+    //! Checks whether the given peer shows the given channel, or never declared an interest
+    bool isSyncInterested(const Peer *peer, const IrcChannel *ircChannel) const;
+
 public slots:
     void addClient(RemotePeer *peer);
     void addClient(InternalPeer *peer);
@@ -129,6 +142,12 @@ public slots:
 
     void changePassword(PeerPtr peer, const QString &userName, const QString &oldPassword, const QString &newPassword);
 
+    //! Sets the buffers a client is interested in
+    /** \param peer    The client declaring its interest
+     *  \param buffers The BufferInfos of the buffers the client shows
+     */
+    void setSyncInterest(PeerPtr peer, const QVariantList &buffers);
+
     QHash<QString, QString> persistentChannels(NetworkId) const;
 
     //! Marks us away (or unaway) on all networks
@@ -198,6 +217,7 @@ private:
     // QHash<NetworkId, NetworkConnection *> _connections;
     QHash<NetworkId, CoreNetwork *> _networks;
     //  QHash<NetworkId, CoreNetwork *> _networksToRemove;
+    QHash<const Peer *, QHash<NetworkId, QSet<QString> > > _syncInterest;
     QHash<IdentityId, CoreIdentity *> _identities;
 
     CoreBufferSyncer *_bufferSyncer;
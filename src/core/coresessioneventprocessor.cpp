@@ -223,13 +223,17 @@ void CoreSessionEventProcessor::processIrcEventMode(IrcEvent *e)
     if (e->network()->isChannelName(e->params().first())) {
         // Channel Modes
 
-        IrcChannel *channel = e->network()->ircChannel(e->params()[0]);
+        CoreIrcChannel *channel = qobject_cast<CoreIrcChannel *>(e->network()->ircChannel(e->params()[0]));
         if (!channel) {
             // we received mode information for a channel we're not in. that means probably we've just been kicked out or something like that
             // anyways: we don't have a place to store the data --> discard the info.
             return;
         }
 
+        // collect the whole line, so the channel can apply and sync it in one go
+        QString changes;
+        QStringList values;
+
         QString modes = e->params()[1];
         bool add = true;
         int paramOffset = 2;
@@ -261,11 +265,17 @@ void CoreSessionEventProcessor::processIrcEventMode(IrcEvent *e)
                                     break;
                                 }
                             }
-                            if (!handledByNetsplit)
-                                channel->addUserMode(ircUser, QString(modes[c]));
+                            if (!handledByNetsplit) {
+                                changes += '+';
+                                changes += modes[c];
+                                values << ircUser->nick();
+                            }
+                        }
+                        else {
+                            changes += '-';
+                            changes += modes[c];
+                            values << ircUser->nick();
                         }
-                        else
-                            channel->removeUserMode(ircUser, QString(modes[c]));
                     }
                 }
                 else {
@@ -287,12 +297,12 @@ void CoreSessionEventProcessor::processIrcEventMode(IrcEvent *e)
                     ++paramOffset;
                 }
 
-                if (add)
-                    channel->addChannelMode(modes[c], value);
-                else
-                    channel->removeChannelMode(modes[c], value);
+                changes += add ? '+' : '-';
+                changes += modes[c];
+                values << value;
             }
         }
+        channel->applyModeLine(changes, values);
     }
     else {
         // pure User Modes
@@ -654,6 +664,8 @@ void CoreSessionEventProcessor::processIrcEvent315(IrcEvent *e)
     if (!checkParamCount(e, 1))
         return;
 
+    coreNetwork(e)->flushWhoDetails(e->params()[0]);
+
     if (coreNetwork(e)->setAutoWhoDone(e->params()[0]))
         e->setFlag(EventManager::Silent);
 }
@@ -760,13 +772,20 @@ void CoreSessionEventProcessor::processIrcEvent352(IrcEvent *e)
     QString channel = e->params()[0];
     IrcUser *ircuser = e->network()->ircUser(e->params()[4]);
     if (ircuser) {
-        ircuser->setUser(e->params()[1]);
-        ircuser->setHost(e->params()[2]);
-
-        bool away = e->params()[5].startsWith("G");
-        ircuser->setAway(away);
-        ircuser->setServer(e->params()[3]);
-        ircuser->setRealName(e->params().last().section(" ", 1));
+        QVariantMap details;
+        details["user"] = e->params()[1];
+        details["host"] = e->params()[2];
+        details["away"] = e->params()[5].startsWith("G");
+        details["server"] = e->params()[3];
+        details["realName"] = e->params().last().section(" ", 1);
+
+        // an auto-WHO's details are synced in one go at its RPL_ENDOFWHO; other WHOs (of masks, nicks
+        // or whatever the user asked for) may never end with the channel's name, so sync those right away
+        QVariantMap changed = ircuser->applyDetails(details);
+        if (coreNetwork(e)->isAutoWhoInProgress(channel))
+            coreNetwork(e)->addWhoDetails(channel, ircuser->nick(), changed);
+        else
+            ircuser->syncDetails(changed);
     }
 
     if (coreNetwork(e)->isAutoWhoInProgress(channel))
@@ -1063,6 +1082,9 @@ void CoreSessionEventProcessor::handleCtcpDcc(CtcpEvent *e)
 
             // TODO: check if target is the right thing to use for the partner
             CoreTransfer *transfer = new CoreTransfer(Transfer::Receive, e->target(), filename, address, port, size, this);
+            QString storagePath = coreSession()->transferManager()->storagePathForIncoming(filename);
+            if (!storagePath.isEmpty())
+                transfer->setStoragePath(storagePath);
             coreSession()->signalProxy()->synchronize(transfer);
             coreSession()->transferManager()->addTransfer(transfer);
         }
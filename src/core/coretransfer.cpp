@@ -20,12 +20,17 @@
 
 #include <QtEndian>
 
-#include <QCoreApplication>
+#include <QFile>
 #include <QTcpSocket>
+#include <QTimer>
+#include <QUuid>
 
 #include "coretransfer.h"
+#include "remotepeer.h"
+#include "transferthread.h"
 
-const qint64 chunkSize = 16 * 1024;
+const qint64 chunkSize = 32 * 1024;
+const qint64 relayWindow = 256 * 1024; // how much data may be on its way to the client
 
 INIT_SYNCABLE_OBJECT(CoreTransfer)
 
@@ -33,27 +38,61 @@ CoreTransfer::CoreTransfer(Direction direction, const QString &nick, const QStri
     : Transfer(direction, nick, fileName, address, port, fileSize, parent),
     _socket(0),
     _pos(0),
-    _reading(false)
+    _relayed(0),
+    _acknowledged(0),
+    _peerAcknowledges(false),
+    _sizeLimit(0),
+    _thread(0),
+    _serveThread(0),
+    _storedFile(0)
 {
 
 }
 
 
+CoreTransfer::~CoreTransfer()
+{
+    cleanUp();
+    stopSendingStored();
+}
+
+
+void CoreTransfer::setStoragePath(const QString &path)
+{
+    _storagePath = path;
+}
+
+
+void CoreTransfer::refuse(const QString &reason)
+{
+    setError(reason);
+}
+
+
 void CoreTransfer::cleanUp()
 {
+    if (_thread) {
+        // the thread checks for being aborted several times a second, so this doesn't block for long
+        _thread->abort();
+        _thread->wait();
+        delete _thread;
+        _thread = 0;
+    }
+
     if (_socket) {
         _socket->close();
         _socket->deleteLater();
         _socket = 0;
     }
-
-    _buffer.clear();
-    _reading = false;
 }
 
 
 void CoreTransfer::onSocketDisconnected()
 {
+    // the sender may be done long before the client caught up with the data
+    if (state() == Transferring && _socket->bytesAvailable())
+        return;
+
     if (state() == Connecting || state() == Transferring) {
         setError(tr("Socket closed while still transferring!"));
     }
@@ -74,9 +113,26 @@ void CoreTransfer::onSocketError(QAbstractSocket::SocketError error)
 
 void CoreTransfer::requestAccepted(PeerPtr peer)
 {
-    if (_peer || !peer || state() != New)
+    if (_peer || !peer)
         return; // transfer was already accepted
 
+    if (isStoredOnCore()) {
+        // The core does the DCC part, the client just gets the file once it's complete. Whether the
+        // file may be stored at all is up to CoreTransferManager::startStoredTransfer().
+        if (direction() != Receive || (state() != New && state() != Completed))
+            return;
+        _peer = peer;
+        if (state() == New)
+            setState(Pending);
+        emit accepted(peer);
+        if (state() == Completed)
+            startSendingStored();
+        return;
+    }
+
+    if (state() != New)
+        return;
+
     _peer = peer;
     setState(Pending);
 
@@ -101,6 +157,12 @@ void CoreTransfer::requestRejected(PeerPtr peer)
 
 void CoreTransfer::start()
 {
+    if (isStoredOnCore()) {
+        if (!_thread && state() == Pending)
+            startThread();
+        return;
+    }
+
     if (!_peer || state() != Pending || direction() != Receive)
         return;
 
@@ -118,6 +180,8 @@ void CoreTransfer::setupConnectionForReceive()
     setState(Connecting);
 
     _socket = new QTcpSocket(this);
+    // once the client can't keep up, this stops reading and thus the sender, too
+    _socket->setReadBufferSize(relayWindow);
     connect(_socket, SIGNAL(connected()), SLOT(startReceiving()));
     connect(_socket, SIGNAL(disconnected()), SLOT(onSocketDisconnected()));
     connect(_socket, SIGNAL(error(QAbstractSocket::SocketError)), SLOT(onSocketError(QAbstractSocket::SocketError)));
@@ -135,25 +199,25 @@ void CoreTransfer::startReceiving()
 
 void CoreTransfer::onDataReceived()
 {
-    if (_reading) // since we're spinning the event loop, we may get another readyRead() and thus reentrancy
+    if (!_socket)
         return;
-    _reading = true;
 
-    while (_socket->bytesAvailable()) {
+    qint64 received = 0;
+    while (_socket->bytesAvailable() && canRelay()) {
         QByteArray data = _socket->read(chunkSize);
-        _pos += data.size();
-        if (!relayData(data, true))
-            return;
-
-        QCoreApplication::processEvents();  // don't block the rest of the core/client communication
-        if (!_socket)  // just in case something happened during spinning the event loop that killed our socket
+        if (!relayData(data))
             return;
+        _pos += data.size();
+        received += data.size();
     }
 
-    // Send ack to sender. The DCC protocol only specifies 32 bit values, but modern clients (i.e. those who can send files
-    // larger than 4 GB) will ignore this anyway...
-    quint32 ack = qToBigEndian((quint32)_pos);// qDebug() << Q_FUNC_INFO << _pos;
-    _socket->write((char *)&ack, 4);
+    if (received) {
+        // Send ack to sender. The DCC protocol only specifies 32 bit values, but modern clients (i.e. those who can send files
+        // larger than 4 GB) will ignore this anyway...
+        quint32 ack = qToBigEndian((quint32)_pos);
+        _socket->write((char *)&ack, 4);
+        updateTransferred(_pos);
+    }
 
     if (_pos > fileSize()) {
         qWarning() << "DCC Receive: Got more data than expected!";
@@ -161,28 +225,236 @@ void CoreTransfer::onDataReceived()
     }
     else if (_pos == fileSize()) {
         qDebug() << "DCC Receive: Transfer finished";
-        if (relayData(QByteArray(), false)) // empty buffer
-            setState(Completed);
+        setTransferred(_pos);
+        setState(Completed);
+        if (_socket->state() == QAbstractSocket::UnconnectedState)
+            cleanUp();
+    }
+    else if (_socket->bytesAvailable()) {
+        // The sender has to wait for the client to catch up. A full window makes us continue in
+        // dataAcknowledged(), a backlog on the client socket has to be checked back on.
+        if (!isWindowFull())
+            QTimer::singleShot(50, this, SLOT(onDataReceived()));
+    }
+    else if (_socket->state() == QAbstractSocket::UnconnectedState) {
+        setError(tr("Socket closed while still transferring!"));
     }
-
-    _reading = false;
 }
 
 
-bool CoreTransfer::relayData(const QByteArray &data, bool requireChunkSize)
+bool CoreTransfer::relayData(const QByteArray &data)
 {
     // safeguard against a disconnecting quasselclient
     if (!_peer) {
         setError(tr("DCC Receive: Quassel Client disconnected during transfer!"));
         return false;
     }
-    _buffer.append(data);
 
-    // we only want to send data to the client once we have reached the chunksize
-    if (_buffer.size() > 0 && (_buffer.size() >= chunkSize || !requireChunkSize)) {
-        SYNC_OTHER(dataReceived, ARG(_peer), ARG(_buffer));
-        _buffer.clear();
+    SYNC_OTHER(dataReceived, ARG(_peer), ARG(data));
+    _relayed += data.size();
+    return true;
+}
+
+
+bool CoreTransfer::isWindowFull() const
+{
+    // clients acknowledging the data they got are kept within a window
+    return _peerAcknowledges && _relayed - _acknowledged >= (quint64)relayWindow;
+}
+
+
+bool CoreTransfer::canRelay() const
+{
+    if (isWindowFull())
+        return false;
+
+    // in any case, file data must not pile up in front of the chat traffic to the client
+    RemotePeer *remotePeer = qobject_cast<RemotePeer *>(_peer.data());
+    return !remotePeer || !remotePeer->socket() || remotePeer->socket()->bytesToWrite() < relayWindow / 2;
+}
+
+
+void CoreTransfer::dataAcknowledged(PeerPtr peer, quint64 bytes)
+{
+    if (!_peer || peer != _peer)
+        return;
+
+    _peerAcknowledges = true;
+    _acknowledged = bytes;
+
+    // the client caught up, so there may be room for more
+    if (_socket)
+        onDataReceived();
+    else if (_storedFile)
+        sendNextStoredChunk();
+}
+
+
+void CoreTransfer::updateTransferred(quint64 transferred)
+{
+    // once a second is plenty for showing progress and throughput
+    if (_transferredTimer.isValid() && _transferredTimer.elapsed() < 1000)
+        return;
+
+    _transferredTimer.start();
+    setTransferred(transferred);
+}
+
+
+/*** Transfers stored on the core ***/
+
+void CoreTransfer::startThread()
+{
+    setState(Connecting);
+
+    _thread = new TransferThread(direction(), _storagePath, address(), port(), fileSize());
+    _thread->setSizeLimit(_sizeLimit);
+    connect(_thread, SIGNAL(listening(quint16)), SLOT(onThreadListening(quint16)));
+    connect(_thread, SIGNAL(transferStarted()), SLOT(onThreadStarted()));
+    connect(_thread, SIGNAL(progress(quint64)), SLOT(setTransferred(quint64)));
+    connect(_thread, SIGNAL(transferCompleted(quint64)), SLOT(onThreadCompleted(quint64)));
+    connect(_thread, SIGNAL(transferFailed(QString)), SLOT(setError(QString)));
+    _thread->start();
+}
+
+
+void CoreTransfer::onThreadListening(quint16 port)
+{
+    setPort(port);
+    emit listening();
+}
+
+
+void CoreTransfer::onThreadStarted()
+{
+    setState(Transferring);
+}
+
+
+void CoreTransfer::onThreadCompleted(quint64 size)
+{
+    if (direction() == Receive && size != fileSize())
+        setFileSize(size); // the sender may not have told us the size
+    setTransferred(size);
+
+    cleanUp();
+    setState(Completed);
+
+    if (_peer && direction() == Receive)
+        startSendingStored();
+}
+
+
+void CoreTransfer::startSendingStored()
+{
+    if (_storedFile || _serveThread)
+        return;
+
+    // the extra connection isn't encrypted, so it must not be used if the client's one is (local ones don't need to be)
+    if (_peer->features().testFlag(Quassel::StoredTransferConnection) && (!_peer->isSecure() || _peer->isLocal())) {
+        startServing();
+        return;
     }
 
-    return true;
+    // other clients get the file through the SignalProxy, passing the session thread
+    _storedFile = new QFile(_storagePath, this);
+    if (!_storedFile->open(QIODevice::ReadOnly)) {
+        qWarning() << Q_FUNC_INFO << "Could not open stored file:" << _storedFile->errorString();
+        stopSendingStored();
+        return;
+    }
+    sendNextStoredChunk();
+}
+
+
+void CoreTransfer::sendNextStoredChunk()
+{
+    if (!_storedFile)
+        return;
+
+    // safeguard against a disconnecting quasselclient
+    if (!_peer) {
+        stopSendingStored();
+        return;
+    }
+
+    // wait for the client to catch up, just like when relaying
+    if (!canRelay()) {
+        if (!isWindowFull())
+            QTimer::singleShot(50, this, SLOT(sendNextStoredChunk()));
+        return;
+    }
+
+    QByteArray data = _storedFile->read(chunkSize);
+    if (!data.isEmpty()) {
+        SYNC_OTHER(dataReceived, ARG(_peer), ARG(data));
+        _relayed += data.size();
+    }
+
+    if (data.size() < chunkSize || _storedFile->atEnd()) {
+        stopSendingStored();
+        return;
+    }
+    QTimer::singleShot(0, this, SLOT(sendNextStoredChunk()));
+}
+
+
+void CoreTransfer::startServing()
+{
+    // listen where the client reached us
+    QHostAddress address = QHostAddress::LocalHost;
+    RemotePeer *remotePeer = qobject_cast<RemotePeer *>(_peer.data());
+    if (remotePeer && remotePeer->socket())
+        address = remotePeer->socket()->localAddress();
+
+    // anyone can connect, but only the client knows the token
+    _serveToken = QUuid::createUuid().toRfc4122() + QUuid::createUuid().toRfc4122();
+
+    _serveThread = new TransferThread(Send, _storagePath, address, 0, fileSize());
+    _serveThread->setToken(_serveToken);
+    connect(_serveThread, SIGNAL(listening(quint16)), SLOT(onServeThreadListening(quint16)));
+    connect(_serveThread, SIGNAL(transferCompleted(quint64)), SLOT(stopServing()));
+    connect(_serveThread, SIGNAL(transferFailed(QString)), SLOT(onServeThreadFailed(QString)));
+    _serveThread->start();
+}
+
+
+void CoreTransfer::onServeThreadListening(quint16 port)
+{
+    if (!_peer) {
+        stopServing();
+        return;
+    }
+    SYNC_OTHER(storedFileReady, ARG(_peer), ARG(port), ARG(_serveToken));
+}
+
+
+void CoreTransfer::onServeThreadFailed(const QString &errorString)
+{
+    // the transfer itself is complete, only this client didn't get it
+    qWarning() << "Could not send stored file" << _storagePath << "to the client:" << errorString;
+    stopServing();
+}
+
+
+void CoreTransfer::stopServing()
+{
+    if (_serveThread) {
+        _serveThread->abort();
+        _serveThread->wait();
+        delete _serveThread;
+        _serveThread = 0;
+    }
+}
+
+
+void CoreTransfer::stopSendingStored()
+{
+    stopServing();
+
+    if (_storedFile) {
+        _storedFile->close();
+        delete _storedFile;
+        _storedFile = 0;
+    }
 }
@@ -21,12 +21,15 @@
 #ifndef CORETRANSFER_H
 #define CORETRANSFER_H
 
+#include <QElapsedTimer>
 #include <QPointer>
 
 #include "transfer.h"
 #include "peer.h"
 
+class QFile;
 class QTcpSocket;
+class TransferThread;
 
 class CoreTransfer : public Transfer
 {
@@ -35,6 +38,23 @@ class CoreTransfer : public Transfer
 
 public:
     CoreTransfer(Direction direction, const QString &nick, const QString &fileName, const QHostAddress &address, quint16 port, quint64 size = 0, QObject *parent = 0);
+    ~CoreTransfer();
+
+    //! Makes the core store the file at the given path, instead of relaying it to the client
+    /** The DCC connection is then handled in a thread of its own. Clients accepting a stored
+     *  transfer get the file from the core's disk once it is complete, through a connection of
+     *  its own that is served by another thread (Quassel::StoredTransferConnection).
+     */
+    void setStoragePath(const QString &path);
+    inline QString storagePath() const { return _storagePath; }
+    inline bool isStoredOnCore() const { return !_storagePath.isEmpty(); }
+
+    //! The most a stored incoming transfer may write to disk, see CoreTransferManager::startStoredTransfer()
+    inline quint64 sizeLimit() const { return _sizeLimit; }
+    inline void setSizeLimit(quint64 sizeLimit) { _sizeLimit = sizeLimit; }
+
+    //! Fails the transfer before it started, e.g. because the core doesn't want to store the file
+    void refuse(const QString &reason);
 
 public slots:
     void start();
@@ -42,6 +62,7 @@ public slots:
     // called through sync calls
     void requestAccepted(PeerPtr peer);
     void requestRejected(PeerPtr peer);
+    void dataAcknowledged(PeerPtr peer, quint64 bytes);
 
 private slots:
     void startReceiving();
@@ -49,16 +70,44 @@ private slots:
     void onSocketDisconnected();
     void onSocketError(QAbstractSocket::SocketError error);
 
+    void onThreadListening(quint16 port);
+    void onThreadStarted();
+    void onThreadCompleted(quint64 size);
+    void onServeThreadListening(quint16 port);
+    void onServeThreadFailed(const QString &errorString);
+    void stopServing();
+    void sendNextStoredChunk();
+
+signals:
+    //! Emitted for a stored outgoing transfer once the receiver can connect on port()
+    void listening();
+
 private:
     void setupConnectionForReceive();
-    bool relayData(const QByteArray &data, bool requireChunkSize);
+    bool relayData(const QByteArray &data);
+    bool isWindowFull() const;
+    bool canRelay() const;
+    void updateTransferred(quint64 transferred);
     virtual void cleanUp();
+    void startThread();
+    void startSendingStored();
+    void startServing();
+    void stopSendingStored();
 
     QPointer<Peer> _peer;
     QTcpSocket *_socket;
     quint64 _pos;
-    QByteArray _buffer;
-    bool _reading;
+    quint64 _relayed;      // sent to the client
+    quint64 _acknowledged; // written by the client
+    bool _peerAcknowledges;
+    QElapsedTimer _transferredTimer;
+
+    QString _storagePath;
+    quint64 _sizeLimit;
+    TransferThread *_thread;
+    TransferThread *_serveThread; // serves the stored file to the client
+    QByteArray _serveToken;
+    QFile *_storedFile; // the stored file while relaying it to older clients
 };
 
 #endif
@@ -20,11 +20,19 @@
 
 #include "coretransfermanager.h"
 
+#include <QDir>
+#include <QFileInfo>
+#include <QSet>
+
+#include "peer.h"
+
 #include "coretransfer.h"
 
 INIT_SYNCABLE_OBJECT(CoreTransferManager)
 CoreTransferManager::CoreTransferManager(QObject *parent)
-    : TransferManager(parent)
+    : TransferManager(parent),
+    _maxFileSize(0),
+    _quota(0)
 {
     connect(this, SIGNAL(transferAdded(const Transfer*)), SLOT(onTransferAdded(const Transfer*)));
 }
@@ -36,6 +44,66 @@ CoreTransfer *CoreTransferManager::transfer(const QUuid &uuid) const
 }
 
 
+void CoreTransferManager::setStorageDir(const QString &dir)
+{
+    _storageDir = dir;
+}
+
+
+void CoreTransferManager::setStorageLimits(quint64 maxFileSize, quint64 quota)
+{
+    _maxFileSize = maxFileSize;
+    _quota = quota;
+}
+
+
+quint64 CoreTransferManager::usedStorage() const
+{
+    quint64 used = 0;
+    foreach(const QFileInfo &info, QDir(_storageDir).entryInfoList(QDir::Files|QDir::Hidden))
+        used += info.size();
+
+    foreach(const QUuid &uuid, transferIds()) {
+        CoreTransfer *t = transfer(uuid);
+        if (t && t->isStoredOnCore() && t->direction() == Transfer::Receive
+            && (t->state() == Transfer::Connecting || t->state() == Transfer::Transferring))
+            used += t->sizeLimit() - qMin(t->sizeLimit(), t->transferred());
+    }
+    return used;
+}
+
+
+QString CoreTransferManager::storagePathForIncoming(const QString &fileName) const
+{
+    if (_storageDir.isEmpty())
+        return QString();
+
+    // never trust a remote file name with a path
+    QString name = QFileInfo(fileName).fileName();
+    if (name.isEmpty() || name.startsWith('.'))
+        name.prepend("dcc");
+
+    QDir dir(_storageDir);
+    if (!dir.exists() && !dir.mkpath(".")) {
+        qWarning() << "Could not create DCC storage directory" << _storageDir;
+        return QString();
+    }
+
+    // paths of transfers that haven't written their file yet are taken as well
+    QSet<QString> reserved;
+    foreach(const QUuid &uuid, transferIds()) {
+        CoreTransfer *t = transfer(uuid);
+        if (t && t->isStoredOnCore())
+            reserved.insert(t->storagePath());
+    }
+
+    QString path = dir.absoluteFilePath(name);
+    for (int i = 1; QFile::exists(path) || reserved.contains(path); i++)
+        path = dir.absoluteFilePath(QString("%1.%2").arg(name).arg(i));
+    return path;
+}
+
+
 void CoreTransferManager::addTransfer(CoreTransfer *transfer)
 {
     TransferManager::addTransfer(transfer);
@@ -51,5 +119,36 @@ void CoreTransferManager::onTransferAdded(const Transfer *transfer)
         return;
     }
 
+    connect(t, SIGNAL(accepted(PeerPtr)), SLOT(startStoredTransfer()));
     emit transferAdded(t);
 }
+
+
+void CoreTransferManager::startStoredTransfer()
+{
+    CoreTransfer *t = qobject_cast<CoreTransfer *>(sender());
+    if (!t || !t->isStoredOnCore() || t->direction() != Transfer::Receive || t->state() != Transfer::Pending)
+        return;
+
+    // it's the core connecting here, not the user's machine
+    if (t->port() < 1024) {
+        t->refuse(tr("Refusing to connect to privileged port %1 to store a file on the core").arg(t->port()));
+        return;
+    }
+
+    quint64 used = usedStorage();
+    quint64 available = _quota > used ? _quota - used : 0;
+    quint64 limit = qMin(_maxFileSize, available);
+    if (t->fileSize() > _maxFileSize) {
+        t->refuse(tr("The file is larger than the %1 MiB allowed on the core").arg(_maxFileSize / (1024 * 1024)));
+        return;
+    }
+    if (!limit || t->fileSize() > limit) {
+        t->refuse(tr("Not enough space left in your DCC quota on the core"));
+        return;
+    }
+
+    // without a size given, the sender may fill up what's left
+    t->setSizeLimit(t->fileSize() ? t->fileSize() : limit);
+    t->start();
+}
@@ -36,6 +36,19 @@ public:
 
     CoreTransfer *transfer(const QUuid &uuid) const;
 
+    //! The directory incoming files are stored in on the core, or a null string if they're relayed to the client
+    inline QString storageDir() const { return _storageDir; }
+    void setStorageDir(const QString &dir);
+
+    //! Limits the size of a single stored file and the space all of the user's stored files may take up
+    void setStorageLimits(quint64 maxFileSize, quint64 quota);
+
+    //! Returns a path in the storage directory for a file offered by someone else, or a null string if that's not possible
+    /** Only the file name part of \a fileName is used. Neither existing files nor the paths of other
+     *  stored transfers are ever handed out, so the transfer has to be added right after picking its path.
+     */
+    QString storagePathForIncoming(const QString &fileName) const;
+
 public slots:
     void addTransfer(CoreTransfer *transfer);
 
@@ -45,6 +58,16 @@ signals:
 private slots:
     void onTransferAdded(const Transfer *transfer);
 
+    //! Starts receiving a file into the storage directory, once a client accepted it and it fits in
+    void startStoredTransfer();
+
+private:
+    //! Space taken up by stored files, plus what running transfers may still write
+    quint64 usedStorage() const;
+
+    QString _storageDir;
+    quint64 _maxFileSize;
+    quint64 _quota;
 };
 
 #endif
@@ -22,10 +22,17 @@
 
 #include "util.h"
 
+#include "coretransfer.h"
+#include "coretransfermanager.h"
 #include "ctcpparser.h"
+#include "quassel.h"
 
+#include <QDir>
+#include <QFileInfo>
 #include <QRegExp>
 
+#include <algorithm>
+
 #ifdef HAVE_QCA2
 #  include "cipher.h"
 #endif
@@ -46,8 +53,78 @@ void CoreUserInputHandler::handleUserInput(const BufferInfo &bufferInfo, const Q
     for (int i = 0; i < list.count(); i++) {
         QString cmd = list.at(i).second.section(' ', 0, 0).remove(0, 1).toUpper();
         QString payload = list.at(i).second.section(' ', 1);
-        handle(cmd, Q_ARG(BufferInfo, list.at(i).first), Q_ARG(QString, payload));
-    }
+        InputHandler handler = inputHandler(cmd);
+        if (handler)
+            (this->*handler)(list.at(i).first, payload);
+        else
+            defaultHandler(cmd, list.at(i).first, payload);
+    }
+}
+
+
+struct InputCommand {
+    const char *name;
+    void (CoreUserInputHandler::*handler)(const BufferInfo &, const QString &);
+};
+
+
+static bool inputCommandLessThan(const InputCommand &command, const QString &name)
+{
+    return name.compare(QLatin1String(command.name)) > 0;
+}
+
+
+// Looks up the handler for an (uppercase) command in a static table, rather than going through
+// BasicHandler's string-keyed QMetaObject dispatch for every line the user sends.
+CoreUserInputHandler::InputHandler CoreUserInputHandler::inputHandler(const QString &cmd)
+{
+    // must be kept sorted!
+    static const InputCommand commands[] = {
+        { "AWAY", &CoreUserInputHandler::handleAway },
+        { "BAN", &CoreUserInputHandler::handleBan },
+        { "CTCP", &CoreUserInputHandler::handleCtcp },
+        { "DCC", &CoreUserInputHandler::handleDcc },
+        { "DEHALFOP", &CoreUserInputHandler::handleDehalfop },
+        { "DELKEY", &CoreUserInputHandler::handleDelkey },
+        { "DEOP", &CoreUserInputHandler::handleDeop },
+        { "DEVOICE", &CoreUserInputHandler::handleDevoice },
+        { "HALFOP", &CoreUserInputHandler::handleHalfop },
+        { "INVITE", &CoreUserInputHandler::handleInvite },
+        { "JOIN", &CoreUserInputHandler::handleJoin },
+        { "KEYX", &CoreUserInputHandler::handleKeyx },
+        { "KICK", &CoreUserInputHandler::handleKick },
+        { "KILL", &CoreUserInputHandler::handleKill },
+        { "LIST", &CoreUserInputHandler::handleList },
+        { "ME", &CoreUserInputHandler::handleMe },
+        { "MODE", &CoreUserInputHandler::handleMode },
+        { "MSG", &CoreUserInputHandler::handleMsg },
+        { "NICK", &CoreUserInputHandler::handleNick },
+        { "NOTICE", &CoreUserInputHandler::handleNotice },
+        { "OP", &CoreUserInputHandler::handleOp },
+        { "OPER", &CoreUserInputHandler::handleOper },
+        { "PART", &CoreUserInputHandler::handlePart },
+        { "PING", &CoreUserInputHandler::handlePing },
+        { "PRINT", &CoreUserInputHandler::handlePrint },
+        { "QUERY", &CoreUserInputHandler::handleQuery },
+        { "QUIT", &CoreUserInputHandler::handleQuit },
+        { "QUOTE", &CoreUserInputHandler::handleQuote },
+        { "SAY", &CoreUserInputHandler::handleSay },
+        { "SETKEY", &CoreUserInputHandler::handleSetkey },
+        { "SHOWKEY", &CoreUserInputHandler::handleShowkey },
+        { "TOPIC", &CoreUserInputHandler::handleTopic },
+        { "UNBAN", &CoreUserInputHandler::handleUnban },
+        { "VOICE", &CoreUserInputHandler::handleVoice },
+        { "WAIT", &CoreUserInputHandler::handleWait },
+        { "WHO", &CoreUserInputHandler::handleWho },
+        { "WHOIS", &CoreUserInputHandler::handleWhois },
+        { "WHOWAS", &CoreUserInputHandler::handleWhowas },
+    };
+    static const InputCommand *commandsEnd = commands + sizeof(commands) / sizeof(commands[0]);
+
+    const InputCommand *command = std::lower_bound(commands, commandsEnd, cmd, inputCommandLessThan);
+    if (command == commandsEnd || cmd != QLatin1String(command->name))
+        return 0;
+    return command->handler;
 }
 
 
@@ -178,6 +255,63 @@ void CoreUserInputHandler::handleCtcp(const BufferInfo &bufferInfo, const QStrin
 }
 
 
+void CoreUserInputHandler::handleDcc(const BufferInfo &bufferInfo, const QString &msg)
+{
+    Q_UNUSED(bufferInfo)
+
+    // DCC support is unfinished, experimental and potentially dangerous, so make it opt-in
+    if (!Quassel::isOptionSet("enable-experimental-dcc")) {
+        emit displayMsg(Message::Error, BufferInfo::StatusBuffer, "", tr("DCC is disabled on this core."));
+        return;
+    }
+
+    QString nick = msg.section(' ', 1, 1);
+    QString fileName = msg.section(' ', 2);
+    if (msg.section(' ', 0, 0).toUpper() != "SEND" || nick.isEmpty() || fileName.isEmpty()) {
+        emit displayMsg(Message::Info, BufferInfo::StatusBuffer, "", tr("[usage] /dcc send <nick> <file> offers a file from the core's DCC directory to nick."));
+        return;
+    }
+
+    CoreTransferManager *transferManager = coreSession()->transferManager();
+    if (transferManager->storageDir().isEmpty()) {
+        emit displayMsg(Message::Error, BufferInfo::StatusBuffer, "", tr("Sending files requires the core to be started with --dcc-dir."));
+        return;
+    }
+
+    // only files from the DCC directory may be sent
+    QFileInfo file(QDir(transferManager->storageDir()).absoluteFilePath(QFileInfo(fileName).fileName()));
+    if (!file.isFile() || !file.isReadable()) {
+        emit displayMsg(Message::Error, BufferInfo::StatusBuffer, "", tr("No such file in the core's DCC directory: %1").arg(fileName));
+        return;
+    }
+
+    CoreTransfer *transfer = new CoreTransfer(Transfer::Send, nick, file.fileName(), coreNetwork()->localAddress(), 0, file.size(), this);
+    transfer->setStoragePath(file.absoluteFilePath());
+    connect(transfer, SIGNAL(listening()), SLOT(sendDccOffer()));
+    coreSession()->signalProxy()->synchronize(transfer);
+    transferManager->addTransfer(transfer);
+    transfer->start();
+}
+
+
+void CoreUserInputHandler::sendDccOffer()
+{
+    CoreTransfer *transfer = qobject_cast<CoreTransfer *>(sender());
+    if (!transfer)
+        return;
+
+    // IPv4 addresses are sent as a 32 bit number, IPv6 ones as they are
+    QHostAddress address = transfer->address();
+    QString numIp = address.protocol() == QAbstractSocket::IPv4Protocol ? QString::number(address.toIPv4Address()) : address.toString();
+    QString fileName = transfer->fileName();
+    fileName.replace(' ', '_'); // not every client understands quoted file names
+
+    coreSession()->ctcpParser()->query(coreNetwork(), transfer->nick(), "DCC",
+        QString("SEND %1 %2 %3 %4").arg(fileName, numIp).arg(transfer->port()).arg(transfer->fileSize()));
+    emit displayMsg(Message::Action, BufferInfo::StatusBuffer, "", tr("offering %1 to %2 via DCC").arg(transfer->fileName(), transfer->nick()), network()->myNick());
+}
+
+
 void CoreUserInputHandler::handleDelkey(const BufferInfo &bufferInfo, const QString &msg)
 {
     QString bufname = bufferInfo.bufferName().isNull() ? "" : bufferInfo.bufferName();
@@ -602,12 +736,22 @@ void CoreUserInputHandler::handleSay(const BufferInfo &bufferInfo, const QString
         return channelEncode(target, message);
     };
 
+    // clients supporting Quassel::BulkUserInput send a whole paste at once
+    QStringList lines = msg.split('\n', QString::SkipEmptyParts);
+    foreach(const QString &line, lines) {
 #ifdef HAVE_QCA2
-    putPrivmsg(bufferInfo.bufferName(), msg, encodeFunc, network()->cipher(bufferInfo.bufferName()));
+        putPrivmsg(bufferInfo.bufferName(), line, encodeFunc, network()->cipher(bufferInfo.bufferName()));
 #else
-    putPrivmsg(bufferInfo.bufferName(), msg, encodeFunc);
+        putPrivmsg(bufferInfo.bufferName(), line, encodeFunc);
 #endif
-    emit displayMsg(Message::Plain, bufferInfo.type(), bufferInfo.bufferName(), msg, network()->myNick(), Message::Self);
+        emit displayMsg(Message::Plain, bufferInfo.type(), bufferInfo.bufferName(), line, network()->myNick(), Message::Self);
+    }
+
+    if (lines.count() > 1 && network()->sendQueueLength() > 0) {
+        int seconds = network()->sendQueueLength() * network()->messageDelay() / 1000;
+        emit displayMsg(Message::Info, bufferInfo.type(), bufferInfo.bufferName(),
+            tr("Sending %n line(s); flood protection delays the rest by about %1 seconds", 0, lines.count()).arg(seconds));
+    }
 }
 
 
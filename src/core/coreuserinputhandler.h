@@ -43,6 +43,7 @@ public slots:
     void handleBan(const BufferInfo &bufferInfo, const QString &text);
     void handleUnban(const BufferInfo &bufferInfo, const QString &text);
     void handleCtcp(const BufferInfo &bufferInfo, const QString &text);
+    void handleDcc(const BufferInfo &bufferInfo, const QString &text);
     void handleDelkey(const BufferInfo &bufferInfo, const QString &text);
     void handleDeop(const BufferInfo& bufferInfo, const QString &nicks);
     void handleDehalfop(const BufferInfo& bufferInfo, const QString &nicks);
@@ -85,7 +86,14 @@ public slots:
 protected:
     void timerEvent(QTimerEvent *event);
 
+private slots:
+    //! Sends the CTCP offering a file, once the core is ready to send it
+    void sendDccOffer();
+
 private:
+    typedef void (CoreUserInputHandler::*InputHandler)(const BufferInfo &, const QString &);
+    static InputHandler inputHandler(const QString &cmd);
+
     void doMode(const BufferInfo& bufferInfo, const QChar &addOrRemove, const QChar &mode, const QString &nickList);
     void banOrUnban(const BufferInfo &bufferInfo, const QString &text, bool ban);
     void putPrivmsg(const QString &target, const QString &message, std::function<QByteArray(const QString &, const QString &)> encodeFunc, Cipher *cipher = 0);
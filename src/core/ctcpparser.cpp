@@ -27,17 +27,40 @@
 #include "coreuserinputhandler.h"
 
 const QByteArray XDELIM = "\001";
+const char MQUOTE = '\020';
+const char XQUOTE = '\134';
+
+// Quoting tables: the char following the quote char for a byte that needs quoting (or 0), and
+// the byte an escape sequence stands for (or -1 if the quote char isn't followed by a valid one)
+static inline char lowLevelQuoteChar(char c)
+{
+    switch (c) {
+    case '\000': return '0';
+    case '\n': return 'n';
+    case '\r': return 'r';
+    case MQUOTE: return MQUOTE;
+    default: return 0;
+    }
+}
+
+
+static inline int lowLevelDequoteChar(char c)
+{
+    switch (c) {
+    case '0': return '\000';
+    case 'n': return '\n';
+    case 'r': return '\r';
+    case MQUOTE: return MQUOTE;
+    default: return -1;
+    }
+}
+
 
 CtcpParser::CtcpParser(CoreSession *coreSession, QObject *parent)
     : QObject(parent),
-    _coreSession(coreSession)
+    _coreSession(coreSession),
+    _standardCtcp(false)
 {
-    QByteArray MQUOTE = QByteArray("\020");
-    _ctcpMDequoteHash[MQUOTE + '0'] = QByteArray(1, '\000');
-    _ctcpMDequoteHash[MQUOTE + 'n'] = QByteArray(1, '\n');
-    _ctcpMDequoteHash[MQUOTE + 'r'] = QByteArray(1, '\r');
-    _ctcpMDequoteHash[MQUOTE + MQUOTE] = MQUOTE;
-
     setStandardCtcp(_coreSession->networkConfig()->standardCtcp());
 
     connect(_coreSession->networkConfig(), SIGNAL(standardCtcpSet(bool)), this, SLOT(setStandardCtcp(bool)));
@@ -47,12 +70,8 @@ CtcpParser::CtcpParser(CoreSession *coreSession, QObject *parent)
 
 void CtcpParser::setStandardCtcp(bool enabled)
 {
-    QByteArray XQUOTE = QByteArray("\134");
-    if (enabled)
-        _ctcpXDelimDequoteHash[XQUOTE + XQUOTE] = XQUOTE;
-    else
-        _ctcpXDelimDequoteHash.remove(XQUOTE + XQUOTE);
-    _ctcpXDelimDequoteHash[XQUOTE + QByteArray("a")] = XDELIM;
+    // with standard CTCP, the quote char itself is quoted as well
+    _standardCtcp = enabled;
 }
 
 
@@ -71,17 +90,28 @@ void CtcpParser::displayMsg(NetworkEvent *event, Message::Type msgType, const QS
 
 QByteArray CtcpParser::lowLevelQuote(const QByteArray &message)
 {
-    QByteArray quotedMessage = message;
+    const char *data = message.constData();
+    int size = message.size();
 
-    QHash<QByteArray, QByteArray> quoteHash = _ctcpMDequoteHash;
-    QByteArray MQUOTE = QByteArray("\020");
-    quoteHash.remove(MQUOTE + MQUOTE);
-    quotedMessage.replace(MQUOTE, MQUOTE + MQUOTE);
-
-    QHash<QByteArray, QByteArray>::const_iterator quoteIter = quoteHash.constBegin();
-    while (quoteIter != quoteHash.constEnd()) {
-        quotedMessage.replace(quoteIter.value(), quoteIter.key());
-        quoteIter++;
+    int quoteCount = 0;
+    for (int i = 0; i < size; i++) {
+        if (lowLevelQuoteChar(data[i]))
+            quoteCount++;
+    }
+    if (!quoteCount)
+        return message;
+
+    QByteArray quotedMessage;
+    quotedMessage.resize(size + quoteCount);
+    char *out = quotedMessage.data();
+    for (int i = 0; i < size; i++) {
+        char quoted = lowLevelQuoteChar(data[i]);
+        if (quoted) {
+            *out++ = MQUOTE;
+            *out++ = quoted;
+        }
+        else
+            *out++ = data[i];
     }
     return quotedMessage;
 }
@@ -89,35 +119,61 @@ QByteArray CtcpParser::lowLevelQuote(const QByteArray &message)
 
 QByteArray CtcpParser::lowLevelDequote(const QByteArray &message)
 {
+    int pos = message.indexOf(MQUOTE);
+    if (pos < 0)
+        return message;
+
+    const char *data = message.constData();
+    int size = message.size();
+
     QByteArray dequotedMessage;
-    QByteArray messagepart;
-    QHash<QByteArray, QByteArray>::iterator ctcpquote;
-
-    // copy dequote Message
-    for (int i = 0; i < message.size(); i++) {
-        messagepart = message.mid(i, 1);
-        if (i+1 < message.size()) {
-            for (ctcpquote = _ctcpMDequoteHash.begin(); ctcpquote != _ctcpMDequoteHash.end(); ++ctcpquote) {
-                if (message.mid(i, 2) == ctcpquote.key()) {
-                    messagepart = ctcpquote.value();
-                    ++i;
-                    break;
-                }
+    dequotedMessage.resize(size);
+    char *out = dequotedMessage.data();
+    memcpy(out, data, pos);
+    out += pos;
+    for (int i = pos; i < size; i++) {
+        if (data[i] == MQUOTE && i + 1 < size) {
+            int dequoted = lowLevelDequoteChar(data[i + 1]);
+            if (dequoted >= 0) {
+                *out++ = (char)dequoted;
+                i++;
+                continue;
             }
         }
-        dequotedMessage += messagepart;
+        *out++ = data[i];
     }
+    dequotedMessage.resize(out - dequotedMessage.constData());
     return dequotedMessage;
 }
 
 
 QByteArray CtcpParser::xdelimQuote(const QByteArray &message)
 {
-    QByteArray quotedMessage = message;
-    QHash<QByteArray, QByteArray>::const_iterator quoteIter = _ctcpXDelimDequoteHash.constBegin();
-    while (quoteIter != _ctcpXDelimDequoteHash.constEnd()) {
-        quotedMessage.replace(quoteIter.value(), quoteIter.key());
-        quoteIter++;
+    const char *data = message.constData();
+    int size = message.size();
+
+    int quoteCount = 0;
+    for (int i = 0; i < size; i++) {
+        if (data[i] == XDELIM[0] || (_standardCtcp && data[i] == XQUOTE))
+            quoteCount++;
+    }
+    if (!quoteCount)
+        return message;
+
+    QByteArray quotedMessage;
+    quotedMessage.resize(size + quoteCount);
+    char *out = quotedMessage.data();
+    for (int i = 0; i < size; i++) {
+        if (data[i] == XDELIM[0]) {
+            *out++ = XQUOTE;
+            *out++ = 'a';
+        }
+        else if (_standardCtcp && data[i] == XQUOTE) {
+            *out++ = XQUOTE;
+            *out++ = XQUOTE;
+        }
+        else
+            *out++ = data[i];
     }
     return quotedMessage;
 }
@@ -125,23 +181,34 @@ QByteArray CtcpParser::xdelimQuote(const QByteArray &message)
 
 QByteArray CtcpParser::xdelimDequote(const QByteArray &message)
 {
+    int pos = message.indexOf(XQUOTE);
+    if (pos < 0)
+        return message;
+
+    const char *data = message.constData();
+    int size = message.size();
+
     QByteArray dequotedMessage;
-    QByteArray messagepart;
-    QHash<QByteArray, QByteArray>::iterator xdelimquote;
-
-    for (int i = 0; i < message.size(); i++) {
-        messagepart = message.mid(i, 1);
-        if (i+1 < message.size()) {
-            for (xdelimquote = _ctcpXDelimDequoteHash.begin(); xdelimquote != _ctcpXDelimDequoteHash.end(); ++xdelimquote) {
-                if (message.mid(i, 2) == xdelimquote.key()) {
-                    messagepart = xdelimquote.value();
-                    i++;
-                    break;
-                }
+    dequotedMessage.resize(size);
+    char *out = dequotedMessage.data();
+    memcpy(out, data, pos);
+    out += pos;
+    for (int i = pos; i < size; i++) {
+        if (data[i] == XQUOTE && i + 1 < size) {
+            if (data[i + 1] == 'a') {
+                *out++ = XDELIM[0];
+                i++;
+                continue;
+            }
+            if (_standardCtcp && data[i + 1] == XQUOTE) {
+                *out++ = XQUOTE;
+                i++;
+                continue;
             }
         }
-        dequotedMessage += messagepart;
+        *out++ = data[i];
     }
+    dequotedMessage.resize(out - dequotedMessage.constData());
     return dequotedMessage;
 }
 
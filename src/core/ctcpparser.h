@@ -94,8 +94,7 @@ private:
 
     QHash<QUuid, CtcpReply> _replies;
 
-    QHash<QByteArray, QByteArray> _ctcpMDequoteHash;
-    QHash<QByteArray, QByteArray> _ctcpXDelimDequoteHash;
+    bool _standardCtcp;
 };
 
 
@@ -26,7 +26,38 @@
 
 EventStringifier::EventStringifier(CoreSession *parent) : BasicHandler("handleCtcp", parent),
     _coreSession(parent),
-    _whois(false)
+    _whois(false),
+    _inviteTemplate(tr("%1 invited you to channel %2")),
+    _topicChangeTemplate(tr("%1 has changed topic for %2 to: \"%3\"")),
+    _wallopsTemplate(tr("[Operwall] %1: %2")),
+    _awayTemplate(tr("%1 is away: \"%2\"")),
+    _whoisUserTemplate(tr("[Whois] %1 is %2 (%3)")),
+    _whoisServerTemplate(tr("[Whois] %1 is online via %2 (%3)")),
+    _whowasServerTemplate(tr("[Whowas] %1 was online via %2 (%3)")),
+    _whowasUserTemplate(tr("[Whowas] %1 was %2@%3 (%4)")),
+    _endOfWhoTemplate(tr("[Who] End of /WHO list for %1")),
+    _whoisLoginTemplate(tr("[Whois] %1 is logged in since %2")),
+    _whoisIdleTemplate(tr("[Whois] %1 is idling for %2 (since %3)")),
+    _whoisUserChannelsTemplate(tr("[Whois] %1 is a user on channels: %2")),
+    _whoisVoiceChannelsTemplate(tr("[Whois] %1 has voice on channels: %2")),
+    _whoisOpChannelsTemplate(tr("[Whois] %1 is an operator on channels: %2")),
+    _listTemplate(tr("Channel %1 has %2 users. Topic is: \"%3\"")),
+    _homepageTemplate(tr("Homepage for %1 is %2")),
+    _channelCreatedTemplate(tr("Channel %1 created on %2")),
+    _whoisAccountTemplate(tr("[Whois] %1 is authed as %2")),
+    _whowasAccountTemplate(tr("[Whowas] %1 was authed as %2")),
+    _noTopicTemplate(tr("No topic is set for %1.")),
+    _topicTemplate(tr("Topic for %1 is \"%2\"")),
+    _topicSetByTemplate(tr("Topic set by %1 on %2")),
+    _invitingTemplate(tr("%1 has been invited to %2")),
+    _whoReplyTemplate(tr("[Who] %1")),
+    _erroneousNickTemplate(tr("Nick %1 contains illegal characters")),
+    _nickInUseTemplate(tr("Nick already in use: %1")),
+    _unavailableTemplate(tr("Nick/channel is temporarily unavailable: %1")),
+    _ctcpSentTemplate(tr("sending CTCP-%1 request to %2")),
+    _ctcpRequestTemplate(tr("Received %1CTCP-%2 request by %3")),
+    _ctcpAnswerTemplate(tr("Received CTCP-%1 answer from %2: %3")),
+    _ctcpPingAnswerTemplate(tr("Received CTCP-PING answer from %1 with %2 milliseconds round trip time"))
 {
     connect(this, SIGNAL(newMessageEvent(Event *)), coreSession()->eventManager(), SLOT(postEvent(Event *)));
 }
@@ -44,6 +75,18 @@ void EventStringifier::displayMsg(NetworkEvent *event, Message::Type msgType, co
 }
 
 
+bool EventStringifier::filterIrcEvent(Event *event)
+{
+    return !event->testFlag(EventManager::Silent);
+}
+
+
+bool EventStringifier::filterCtcpEvent(Event *event)
+{
+    return !event->testFlag(EventManager::Silent);
+}
+
+
 MessageEvent *EventStringifier::createMessageEvent(NetworkEvent *event, Message::Type msgType, const QString &msg, const QString &sender,
     const QString &target, Message::Flags msgFlags)
 {
@@ -236,7 +279,7 @@ void EventStringifier::processIrcEventNumeric(IrcEventNumeric *e)
 
 void EventStringifier::processIrcEventInvite(IrcEvent *e)
 {
-    displayMsg(e, Message::Invite, tr("%1 invited you to channel %2").arg(e->nick(), e->params().at(1)));
+    displayMsg(e, Message::Invite, _inviteTemplate.arg(e->nick(), e->params().at(1)));
 }
 
 
@@ -338,13 +381,12 @@ void EventStringifier::processIrcEventQuit(IrcEvent *e)
 
 void EventStringifier::processIrcEventTopic(IrcEvent *e)
 {
-    displayMsg(e, Message::Topic, tr("%1 has changed topic for %2 to: \"%3\"")
-        .arg(e->nick(), e->params().at(0), e->params().at(1)), QString(), e->params().at(0));
+    displayMsg(e, Message::Topic, _topicChangeTemplate.arg(e->nick(), e->params().at(0), e->params().at(1)), QString(), e->params().at(0));
 }
 
 void EventStringifier::processIrcEventWallops(IrcEvent *e)
 {
-    displayMsg(e, Message::Server, tr("[Operwall] %1: %2").arg(e->nick(), e->params().join(" ")));
+    displayMsg(e, Message::Server, _wallopsTemplate.arg(e->nick(), e->params().join(" ")));
 }
 
 
@@ -381,7 +423,7 @@ void EventStringifier::processIrcEvent301(IrcEvent *e)
         }
     }
     if (send)
-        displayMsg(e, Message::Server, msg + tr("%1 is away: \"%2\"").arg(nick, awayMsg), QString(), target);
+        displayMsg(e, Message::Server, msg + _awayTemplate.arg(nick, awayMsg), QString(), target);
 }
 
 
@@ -418,14 +460,12 @@ void EventStringifier::processIrcEvent311(IrcEvent *e)
 {
     _whois = true;
 
-    const QString whoisUserString = tr("[Whois] %1 is %2 (%3)");
-
     IrcUser *ircuser = e->network()->ircUser(e->params().at(0));
     if (ircuser)
-        displayMsg(e, Message::Server, whoisUserString.arg(ircuser->nick(), ircuser->hostmask(), ircuser->realName()));
+        displayMsg(e, Message::Server, _whoisUserTemplate.arg(ircuser->nick(), ircuser->hostmask(), ircuser->realName()));
     else {
         QString host = QString("%1!%2@%3").arg(e->params().at(0), e->params().at(1), e->params().at(2));
-        displayMsg(e, Message::Server, whoisUserString.arg(e->params().at(0), host, e->params().last()));
+        displayMsg(e, Message::Server, _whoisUserTemplate.arg(e->params().at(0), host, e->params().last()));
     }
 }
 
@@ -434,9 +474,9 @@ void EventStringifier::processIrcEvent311(IrcEvent *e)
 void EventStringifier::processIrcEvent312(IrcEvent *e)
 {
     if (_whois)
-        displayMsg(e, Message::Server, tr("[Whois] %1 is online via %2 (%3)").arg(e->params().at(0), e->params().at(1), e->params().last()));
+        displayMsg(e, Message::Server, _whoisServerTemplate.arg(e->params().at(0), e->params().at(1), e->params().last()));
     else
-        displayMsg(e, Message::Server, tr("[Whowas] %1 was online via %2 (%3)").arg(e->params().at(0), e->params().at(1), e->params().last()));
+        displayMsg(e, Message::Server, _whowasServerTemplate.arg(e->params().at(0), e->params().at(1), e->params().last()));
 }
 
 
@@ -446,7 +486,7 @@ void EventStringifier::processIrcEvent314(IrcEvent *e)
     if (!checkParamCount(e, 3))
         return;
 
-    displayMsg(e, Message::Server, tr("[Whowas] %1 was %2@%3 (%4)").arg(e->params()[0], e->params()[1], e->params()[2], e->params().last()));
+    displayMsg(e, Message::Server, _whowasUserTemplate.arg(e->params()[0], e->params()[1], e->params()[2], e->params().last()));
 }
 
 
@@ -455,7 +495,7 @@ void EventStringifier::processIrcEvent315(IrcEvent *e)
 {
     QStringList p = e->params();
     p.takeLast(); // should be "End of WHO list"
-    displayMsg(e, Message::Server, tr("[Who] End of /WHO list for %1").arg(p.join(" ")));
+    displayMsg(e, Message::Server, _endOfWhoTemplate.arg(p.join(" ")));
 }
 
 
@@ -467,12 +507,10 @@ void EventStringifier::processIrcEvent317(IrcEvent *e)
 
     if (e->params().count() > 3) { // if we have more then 3 params we have the above mentioned "real life" situation
         QDateTime loginTime = QDateTime::fromTime_t(e->params()[2].toInt()).toUTC();
-        displayMsg(e, Message::Server, tr("[Whois] %1 is logged in since %2")
-	    .arg(e->params()[0], loginTime.toString("yyyy-MM-dd hh:mm:ss UTC")));
+        displayMsg(e, Message::Server, _whoisLoginTemplate.arg(e->params()[0], loginTime.toString("yyyy-MM-dd hh:mm:ss UTC")));
     }
     QDateTime idlingSince = e->timestamp().toLocalTime().addSecs(-idleSecs).toUTC();
-    displayMsg(e, Message::Server, tr("[Whois] %1 is idling for %2 (since %3)")
-        .arg(e->params()[0], secondsToString(idleSecs),
+    displayMsg(e, Message::Server, _whoisIdleTemplate.arg(e->params()[0], secondsToString(idleSecs),
 	     idlingSince.toString("yyyy-MM-dd hh:mm:ss UTC")));
 }
 
@@ -504,11 +542,11 @@ void EventStringifier::processIrcEvent319(IrcEvent *e)
             user.append(channel);
     }
     if (!user.isEmpty())
-        displayMsg(e, Message::Server, tr("[Whois] %1 is a user on channels: %2").arg(nick, user.join(" ")));
+        displayMsg(e, Message::Server, _whoisUserChannelsTemplate.arg(nick, user.join(" ")));
     if (!voice.isEmpty())
-        displayMsg(e, Message::Server, tr("[Whois] %1 has voice on channels: %2").arg(nick, voice.join(" ")));
+        displayMsg(e, Message::Server, _whoisVoiceChannelsTemplate.arg(nick, voice.join(" ")));
     if (!op.isEmpty())
-        displayMsg(e, Message::Server, tr("[Whois] %1 is an operator on channels: %2").arg(nick, op.join(" ")));
+        displayMsg(e, Message::Server, _whoisOpChannelsTemplate.arg(nick, op.join(" ")));
 }
 
 
@@ -529,8 +567,7 @@ void EventStringifier::processIrcEvent322(IrcEvent *e)
     default:
         break;
     }
-    displayMsg(e, Message::Server, tr("Channel %1 has %2 users. Topic is: \"%3\"")
-        .arg(channelName).arg(userCount).arg(topic));
+    displayMsg(e, Message::Server, _listTemplate.arg(channelName, QString::number(userCount), topic));
 }
 
 
@@ -555,7 +592,7 @@ void EventStringifier::processIrcEvent328(IrcEvent *e)
         return;
 
     QString channel = e->params()[0];
-    displayMsg(e, Message::Topic, tr("Homepage for %1 is %2").arg(channel, e->params()[1]), QString(), channel);
+    displayMsg(e, Message::Topic, _homepageTemplate.arg(channel, e->params()[1]), QString(), channel);
 }
 
 
@@ -572,8 +609,7 @@ void EventStringifier::processIrcEvent329(IrcEvent *e)
         return;
     }
     QDateTime time = QDateTime::fromTime_t(unixtime).toUTC();
-    displayMsg(e, Message::Topic, tr("Channel %1 created on %2")
-        .arg(channel, time.toString("yyyy-MM-dd hh:mm:ss UTC")),
+    displayMsg(e, Message::Topic, _channelCreatedTemplate.arg(channel, time.toString("yyyy-MM-dd hh:mm:ss UTC")),
 	QString(), channel);
 }
 
@@ -586,10 +622,10 @@ void EventStringifier::processIrcEvent330(IrcEvent *e)
 
     // check for whois or whowas
     if (_whois) {
-        displayMsg(e, Message::Server, tr("[Whois] %1 is authed as %2").arg(e->params()[0], e->params()[1]));
+        displayMsg(e, Message::Server, _whoisAccountTemplate.arg(e->params()[0], e->params()[1]));
     }
     else {
-        displayMsg(e, Message::Server, tr("[Whowas] %1 was authed as %2").arg(e->params()[0], e->params()[1]));
+        displayMsg(e, Message::Server, _whowasAccountTemplate.arg(e->params()[0], e->params()[1]));
     }
 }
 
@@ -598,7 +634,7 @@ void EventStringifier::processIrcEvent330(IrcEvent *e)
 void EventStringifier::processIrcEvent331(IrcEvent *e)
 {
     QString channel = e->params().first();
-    displayMsg(e, Message::Topic, tr("No topic is set for %1.").arg(channel), QString(), channel);
+    displayMsg(e, Message::Topic, _noTopicTemplate.arg(channel), QString(), channel);
 }
 
 
@@ -606,7 +642,7 @@ void EventStringifier::processIrcEvent331(IrcEvent *e)
 void EventStringifier::processIrcEvent332(IrcEvent *e)
 {
     QString channel = e->params().first();
-    displayMsg(e, Message::Topic, tr("Topic for %1 is \"%2\"").arg(channel, e->params()[1]), QString(), channel);
+    displayMsg(e, Message::Topic, _topicTemplate.arg(channel, e->params()[1]), QString(), channel);
 }
 
 
@@ -618,8 +654,7 @@ void EventStringifier::processIrcEvent333(IrcEvent *e)
 
     QString channel = e->params().first();
     QDateTime topicSetTime = QDateTime::fromTime_t(e->params()[2].toInt()).toUTC();
-    displayMsg(e, Message::Topic, tr("Topic set by %1 on %2")
-        .arg(e->params()[1],
+    displayMsg(e, Message::Topic, _topicSetByTemplate.arg(e->params()[1],
 	     topicSetTime.toString("yyyy-MM-dd hh:mm:ss UTC")), QString(), channel);
 }
 
@@ -631,7 +666,7 @@ void EventStringifier::processIrcEvent341(IrcEvent *e)
         return;
 
     QString channel = e->params()[1];
-    displayMsg(e, Message::Server, tr("%1 has been invited to %2").arg(e->params().first(), channel), QString(), channel);
+    displayMsg(e, Message::Server, _invitingTemplate.arg(e->params().first(), channel), QString(), channel);
 }
 
 
@@ -639,7 +674,7 @@ void EventStringifier::processIrcEvent341(IrcEvent *e)
               ( "H" / "G" > ["*"] [ ( "@" / "+" ) ] :<hopcount> <real name>" */
 void EventStringifier::processIrcEvent352(IrcEvent *e)
 {
-    displayMsg(e, Message::Server, tr("[Who] %1").arg(e->params().join(" ")));
+    displayMsg(e, Message::Server, _whoReplyTemplate.arg(e->params().join(" ")));
 }
 
 
@@ -656,7 +691,7 @@ void EventStringifier::processIrcEvent432(IrcEvent *e)
     if (!checkParamCount(e, 1))
         return;
 
-    displayMsg(e, Message::Error, tr("Nick %1 contains illegal characters").arg(e->params()[0]));
+    displayMsg(e, Message::Error, _erroneousNickTemplate.arg(e->params()[0]));
 }
 
 
@@ -666,7 +701,7 @@ void EventStringifier::processIrcEvent433(IrcEvent *e)
     if (!checkParamCount(e, 1))
         return;
 
-    displayMsg(e, Message::Error, tr("Nick already in use: %1").arg(e->params()[0]));
+    displayMsg(e, Message::Error, _nickInUseTemplate.arg(e->params()[0]));
 }
 
 
@@ -676,7 +711,7 @@ void EventStringifier::processIrcEvent437(IrcEvent *e)
     if (!checkParamCount(e, 1))
         return;
 
-    displayMsg(e, Message::Error, tr("Nick/channel is temporarily unavailable: %1").arg(e->params()[0]));
+    displayMsg(e, Message::Error, _unavailableTemplate.arg(e->params()[0]));
 }
 
 
@@ -699,7 +734,7 @@ void EventStringifier::processCtcpEvent(CtcpEvent *e)
         return;
 
     if (e->testFlag(EventManager::Self)) {
-        displayMsg(e, Message::Action, tr("sending CTCP-%1 request to %2").arg(e->ctcpCmd(), e->target()), e->network()->myNick());
+        displayMsg(e, Message::Action, _ctcpSentTemplate.arg(e->ctcpCmd(), e->target()), e->network()->myNick());
         return;
     }
 
@@ -715,10 +750,10 @@ void EventStringifier::defaultHandler(const QString &ctcpCmd, CtcpEvent *e)
         if (e->reply().isNull()) // all known core-side handlers (except for ACTION) set a reply!
             //: Optional "unknown" in "Received unknown CTCP-FOO request by bar"
             unknown = tr("unknown") + ' ';
-        displayMsg(e, Message::Server, tr("Received %1CTCP-%2 request by %3").arg(unknown, e->ctcpCmd(), e->prefix()));
+        displayMsg(e, Message::Server, _ctcpRequestTemplate.arg(unknown, e->ctcpCmd(), e->prefix()));
         return;
     }
-    displayMsg(e, Message::Server, tr("Received CTCP-%1 answer from %2: %3").arg(e->ctcpCmd(), nickFromMask(e->prefix()), e->param()));
+    displayMsg(e, Message::Server, _ctcpAnswerTemplate.arg(e->ctcpCmd(), nickFromMask(e->prefix()), e->param()));
 }
 
 
@@ -733,7 +768,7 @@ void EventStringifier::handleCtcpPing(CtcpEvent *e)
     if (e->ctcpType() == CtcpEvent::Query)
         defaultHandler(e->ctcpCmd(), e);
     else {
-        displayMsg(e, Message::Server, tr("Received CTCP-PING answer from %1 with %2 milliseconds round trip time")
-            .arg(nickFromMask(e->prefix())).arg(QDateTime::fromMSecsSinceEpoch(e->param().toULongLong()).msecsTo(e->timestamp())));
+        displayMsg(e, Message::Server, _ctcpPingAnswerTemplate.arg(nickFromMask(e->prefix()),
+            QString::number(QDateTime::fromMSecsSinceEpoch(e->param().toULongLong()).msecsTo(e->timestamp()))));
     }
 }
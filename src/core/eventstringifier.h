@@ -24,6 +24,7 @@
 #include "basichandler.h"
 #include "ircevent.h"
 #include "message.h"
+#include "messagetemplate.h"
 
 class CoreSession;
 class CtcpEvent;
@@ -102,6 +103,10 @@ public:
     Q_INVOKABLE void handleCtcpPing(CtcpEvent *event);
     Q_INVOKABLE void defaultHandler(const QString &cmd, CtcpEvent *event);
 
+    //! Keeps silenced events (e.g. replies to automatic WHOs) from being stringified at all
+    Q_INVOKABLE bool filterIrcEvent(Event *event);
+    Q_INVOKABLE bool filterCtcpEvent(Event *event);
+
 public slots:
     //! Creates and sends a MessageEvent
     void displayMsg(NetworkEvent *event,
@@ -119,6 +124,39 @@ private:
 
     CoreSession *_coreSession;
     bool _whois;
+
+    // translated once, so the handlers only need to fill them in
+    MessageTemplate _inviteTemplate;
+    MessageTemplate _topicChangeTemplate;
+    MessageTemplate _wallopsTemplate;
+    MessageTemplate _awayTemplate;
+    MessageTemplate _whoisUserTemplate;
+    MessageTemplate _whoisServerTemplate;
+    MessageTemplate _whowasServerTemplate;
+    MessageTemplate _whowasUserTemplate;
+    MessageTemplate _endOfWhoTemplate;
+    MessageTemplate _whoisLoginTemplate;
+    MessageTemplate _whoisIdleTemplate;
+    MessageTemplate _whoisUserChannelsTemplate;
+    MessageTemplate _whoisVoiceChannelsTemplate;
+    MessageTemplate _whoisOpChannelsTemplate;
+    MessageTemplate _listTemplate;
+    MessageTemplate _homepageTemplate;
+    MessageTemplate _channelCreatedTemplate;
+    MessageTemplate _whoisAccountTemplate;
+    MessageTemplate _whowasAccountTemplate;
+    MessageTemplate _noTopicTemplate;
+    MessageTemplate _topicTemplate;
+    MessageTemplate _topicSetByTemplate;
+    MessageTemplate _invitingTemplate;
+    MessageTemplate _whoReplyTemplate;
+    MessageTemplate _erroneousNickTemplate;
+    MessageTemplate _nickInUseTemplate;
+    MessageTemplate _unavailableTemplate;
+    MessageTemplate _ctcpSentTemplate;
+    MessageTemplate _ctcpRequestTemplate;
+    MessageTemplate _ctcpAnswerTemplate;
+    MessageTemplate _ctcpPingAnswerTemplate;
 };
 
 
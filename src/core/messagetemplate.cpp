@@ -0,0 +1,110 @@
+/***************************************************************************
+ *   Copyright (C) 2005-2015 by the Quassel Project                        *
+ *   devel@quassel-irc.org                                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3.                                           *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.         *
+ ***************************************************************************/
+
+#include "messagetemplate.h"
+
+#include <QList>
+#include <QSet>
+
+MessageTemplate::MessageTemplate(const QString &format)
+    : _literalLength(0)
+{
+    QList<int> markerSegments; // indices of the segments holding a marker
+    QList<int> markers;        // and their numbers
+    QString text;
+    int i = 0;
+    while (i < format.length()) {
+        // like QString::arg(), accept markers from %1 to %99
+        if (format[i] == '%' && i + 1 < format.length() && format[i + 1].isDigit() && format[i + 1] != '0') {
+            int length = (i + 2 < format.length() && format[i + 2].isDigit()) ? 3 : 2;
+            if (!text.isEmpty()) {
+                _segments << Segment(text, -1);
+                _literalLength += text.length();
+                text.clear();
+            }
+            markerSegments << _segments.count();
+            markers << format.mid(i + 1, length - 1).toInt();
+            _segments << Segment(format.mid(i, length), -1);
+            i += length;
+            continue;
+        }
+        text += format[i++];
+    }
+    if (!text.isEmpty()) {
+        _segments << Segment(text, -1);
+        _literalLength += text.length();
+    }
+
+    // the lowest marker gets the first argument, the next one the second, ...
+    QList<int> sortedMarkers = markers.toSet().toList();
+    qSort(sortedMarkers);
+    for (int m = 0; m < markerSegments.count(); m++)
+        _segments[markerSegments[m]].arg = sortedMarkers.indexOf(markers[m]);
+}
+
+
+QString MessageTemplate::arg(const QString &a1) const
+{
+    const QString *args[] = { &a1 };
+    return expand(args, 1);
+}
+
+
+QString MessageTemplate::arg(const QString &a1, const QString &a2) const
+{
+    const QString *args[] = { &a1, &a2 };
+    return expand(args, 2);
+}
+
+
+QString MessageTemplate::arg(const QString &a1, const QString &a2, const QString &a3) const
+{
+    const QString *args[] = { &a1, &a2, &a3 };
+    return expand(args, 3);
+}
+
+
+QString MessageTemplate::arg(const QString &a1, const QString &a2, const QString &a3, const QString &a4) const
+{
+    const QString *args[] = { &a1, &a2, &a3, &a4 };
+    return expand(args, 4);
+}
+
+
+QString MessageTemplate::expand(const QString *const *args, int argCount) const
+{
+    int length = _literalLength;
+    foreach(const Segment &segment, _segments) {
+        if (segment.arg >= argCount)
+            length += segment.text.length();
+        else if (segment.arg >= 0)
+            length += args[segment.arg]->length();
+    }
+
+    QString result;
+    result.reserve(length);
+    foreach(const Segment &segment, _segments) {
+        if (segment.arg >= 0 && segment.arg < argCount)
+            result += *args[segment.arg];
+        else
+            result += segment.text;
+    }
+    return result;
+}
@@ -0,0 +1,60 @@
+/***************************************************************************
+ *   Copyright (C) 2005-2015 by the Quassel Project                        *
+ *   devel@quassel-irc.org                                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3.                                           *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.         *
+ ***************************************************************************/
+
+#ifndef MESSAGETEMPLATE_H
+#define MESSAGETEMPLATE_H
+
+#include <QString>
+#include <QVector>
+
+//! A (translated) message with %1-style place markers, split up once for filling it in repeatedly
+/** arg() works like QString's multi-arg version: the lowest-numbered markers are replaced by the
+ *  given arguments in order, and markers without a matching argument are left as they are.
+ *  Unlike chained QString::arg() calls, the result is assembled in a single allocation and
+ *  substituted text is never scanned for markers again.
+ */
+class MessageTemplate
+{
+public:
+    MessageTemplate() : _literalLength(0) {}
+    explicit MessageTemplate(const QString &format);
+
+    QString arg(const QString &a1) const;
+    QString arg(const QString &a1, const QString &a2) const;
+    QString arg(const QString &a1, const QString &a2, const QString &a3) const;
+    QString arg(const QString &a1, const QString &a2, const QString &a3, const QString &a4) const;
+
+private:
+    QString expand(const QString *const *args, int argCount) const;
+
+    struct Segment {
+        QString text; // the literal text, or the marker itself
+        int arg;      // index of the argument replacing the marker, -1 for literal text
+
+        Segment() : arg(-1) {}
+        Segment(const QString &text_, int arg_) : text(text_), arg(arg_) {}
+    };
+
+    QVector<Segment> _segments;
+    int _literalLength;
+};
+
+
+#endif
@@ -0,0 +1,460 @@
+/***************************************************************************
+ *   Copyright (C) 2005-2015 by the Quassel Project                        *
+ *   devel@quassel-irc.org                                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3.                                           *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.         *
+ ***************************************************************************/
+
+#include "transferthread.h"
+
+#include <QtEndian>
+
+#include <QFile>
+#include <QHash>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTime>
+
+#ifdef Q_OS_LINUX
+#  include <errno.h>
+#  include <fcntl.h>
+#  include <poll.h>
+#  include <string.h>
+#  include <sys/sendfile.h>
+#  include <sys/socket.h>
+#  include <unistd.h>
+#endif
+
+const int chunkSize = 64 * 1024;   // matches the default capacity of a Linux pipe
+const int pollInterval = 200;      // how often (in ms) a waiting thread checks for being aborted
+const int connectTimeout = 60 * 1000;
+const int acceptTimeout = 180 * 1000;
+const int finalAckTimeout = 30 * 1000;
+const int tokenTimeout = 10 * 1000;
+
+TransferThread::TransferThread(Transfer::Direction direction, const QString &fileName, const QHostAddress &address, quint16 port, quint64 fileSize, QObject *parent)
+    : QThread(parent),
+    _direction(direction),
+    _fileName(fileName),
+    _address(address),
+    _port(port),
+    _fileSize(fileSize),
+    _sizeLimit(0),
+    _aborted(0),
+    _transferred(0),
+    _acked(0)
+{
+    _pipe[0] = _pipe[1] = -1;
+}
+
+
+void TransferThread::abort()
+{
+    _aborted.fetchAndStoreOrdered(1);
+}
+
+
+bool TransferThread::isAborted()
+{
+    return _aborted.fetchAndAddOrdered(0) != 0;
+}
+
+
+void TransferThread::run()
+{
+    // the data bypasses QFile on Linux anyway, so don't let it buffer anything
+    QFile file(_fileName);
+    QIODevice::OpenMode mode = QIODevice::Unbuffered;
+    mode |= (_direction == Transfer::Receive) ? QIODevice::WriteOnly|QIODevice::Truncate : QIODevice::ReadOnly;
+    if (!file.open(mode)) {
+        emit transferFailed(tr("Could not open %1: %2").arg(_fileName, file.errorString()));
+        return;
+    }
+    if (_direction == Transfer::Send)
+        _fileSize = file.size();
+
+    QTcpSocket *socket = (_direction == Transfer::Receive) ? connectToSender() : acceptReceiver();
+    if (!socket) {
+        if (_direction == Transfer::Receive)
+            file.remove();
+        return;
+    }
+
+    emit transferStarted();
+    bool success = (_direction == Transfer::Receive) ? receiveFile(socket, &file) : sendFile(socket, &file);
+
+    socket->abort();
+    delete socket;
+    file.close();
+
+    if (success)
+        emit transferCompleted(_transferred);
+    else if (_direction == Transfer::Receive)
+        file.remove(); // don't let broken files eat up the storage quota
+}
+
+
+QTcpSocket *TransferThread::connectToSender()
+{
+    QTcpSocket *socket = new QTcpSocket;
+    socket->connectToHost(_address, _port);
+
+    QTime time;
+    time.start();
+    while (!socket->waitForConnected(pollInterval)) {
+        if (isAborted()) {
+            delete socket;
+            return 0;
+        }
+        if (socket->state() == QAbstractSocket::UnconnectedState || time.elapsed() > connectTimeout) {
+            emit transferFailed(tr("DCC connection error: %1").arg(socket->errorString()));
+            delete socket;
+            return 0;
+        }
+    }
+    return socket;
+}
+
+
+QTcpSocket *TransferThread::acceptReceiver()
+{
+    QTcpServer server;
+    if (!server.listen(_address, _port)) {
+        emit transferFailed(tr("Could not listen for the DCC connection: %1").arg(server.errorString()));
+        return 0;
+    }
+    emit listening(server.serverPort());
+
+    // connections that still have to send the token, so a silent one can't hold up the right one
+    QHash<QTcpSocket *, QTime> candidates;
+    QTcpSocket *receiver = 0;
+
+    QTime time;
+    time.start();
+    while (!receiver) {
+        if (isAborted())
+            break;
+        if (time.elapsed() > acceptTimeout) {
+            emit transferFailed(tr("Nobody connected to receive the file"));
+            break;
+        }
+
+        bool timedOut = false;
+        if (server.waitForNewConnection(candidates.isEmpty() ? pollInterval : pollInterval / 10, &timedOut)) {
+            QTcpSocket *socket = server.nextPendingConnection();
+            socket->setParent(0);
+            if (_token.isEmpty())
+                receiver = socket;
+            else
+                candidates[socket].start();
+        }
+        else if (!timedOut) {
+            emit transferFailed(tr("DCC connection error: %1").arg(server.errorString()));
+            break;
+        }
+
+        QMutableHashIterator<QTcpSocket *, QTime> it(candidates);
+        while (!receiver && it.hasNext()) {
+            it.next();
+            QTcpSocket *socket = it.key();
+            if (socket->bytesAvailable() < _token.size())
+                socket->waitForReadyRead(0);
+            if (socket->bytesAvailable() >= _token.size()) {
+                if (isValidToken(socket->read(_token.size()))) {
+                    receiver = socket;
+                    it.remove();
+                    break;
+                }
+            }
+            else if (socket->state() == QAbstractSocket::ConnectedState && it.value().elapsed() <= tokenTimeout) {
+                continue;
+            }
+            // not who we're waiting for
+            it.remove();
+            delete socket;
+        }
+    }
+
+    // we only ever accept a single connection
+    qDeleteAll(candidates.keys());
+    server.close();
+    return receiver;
+}
+
+
+bool TransferThread::isValidToken(const QByteArray &token) const
+{
+    // compare all of it, so the time taken doesn't tell how much of the token was right
+    if (token.size() != _token.size())
+        return false;
+    char diff = 0;
+    for (int i = 0; i < token.size(); i++)
+        diff |= token[i] ^ _token[i];
+    return diff == 0;
+}
+
+
+bool TransferThread::receiveFile(QTcpSocket *socket, QFile *file)
+{
+#ifdef Q_OS_LINUX
+    if (pipe(_pipe) < 0) {
+        emit transferFailed(tr("Could not create a pipe: %1").arg(QString::fromLocal8Bit(strerror(errno))));
+        return false;
+    }
+#endif
+
+    bool success = false;
+    while (!isAborted()) {
+        qint64 received = readIntoFile(socket, file);
+        if (received < 0) {
+            if (!_errorString.isEmpty())
+                emit transferFailed(_errorString);
+            // without a known size, the sender closing the connection is all we get
+            else if (_fileSize && _transferred < _fileSize)
+                emit transferFailed(tr("Socket closed while still transferring!"));
+            else
+                success = true;
+            break;
+        }
+        if (!received)
+            continue;
+
+        _transferred += received;
+        writeAck(socket);
+        reportProgress();
+
+        if (_fileSize && _transferred > _fileSize) {
+            emit transferFailed(tr("DCC Receive: Got more data than expected!"));
+            break;
+        }
+        if (_sizeLimit && _transferred > _sizeLimit) {
+            emit transferFailed(tr("DCC Receive: The file is larger than allowed on the core"));
+            break;
+        }
+        if (_fileSize && _transferred == _fileSize) {
+            success = true;
+            break;
+        }
+    }
+
+#ifdef Q_OS_LINUX
+    ::close(_pipe[0]);
+    ::close(_pipe[1]);
+    _pipe[0] = _pipe[1] = -1;
+#endif
+    return success;
+}
+
+
+bool TransferThread::sendFile(QTcpSocket *socket, QFile *file)
+{
+    while (_transferred < _fileSize) {
+        if (isAborted())
+            return false;
+
+        qint64 sent = writeFromFile(socket, file);
+        if (sent < 0) {
+            emit transferFailed(_errorString.isEmpty() ? tr("Socket closed while still transferring!") : _errorString);
+            return false;
+        }
+        _transferred += sent;
+        reportProgress();
+
+        // keep the receiver's acks from piling up
+        readAcks(socket, 0);
+    }
+
+    // The receiver acknowledges the data it got, in 32 bit values (which modern clients ignore for larger files).
+    // Either wait for the final ack, or for the receiver to close the connection.
+    QTime time;
+    time.start();
+    while (_acked != (quint32)_fileSize && time.elapsed() < finalAckTimeout && !isAborted()) {
+        if (!readAcks(socket, pollInterval))
+            break;
+    }
+    return !isAborted();
+}
+
+
+#ifdef Q_OS_LINUX
+
+qint64 TransferThread::readIntoFile(QTcpSocket *socket, QFile *file)
+{
+    int socketFd = socket->socketDescriptor();
+    pollfd pfd = { socketFd, POLLIN, 0 };
+    int ready = poll(&pfd, 1, pollInterval);
+    if (ready <= 0)
+        return 0;
+
+    ssize_t received = splice(socketFd, 0, _pipe[1], 0, chunkSize, SPLICE_F_MOVE|SPLICE_F_NONBLOCK);
+    if (received < 0) {
+        if (errno == EAGAIN || errno == EINTR)
+            return 0;
+        _errorString = tr("DCC connection error: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+        return -1;
+    }
+    if (!received)
+        return -1;
+
+    for (ssize_t left = received; left > 0; ) {
+        ssize_t written = splice(_pipe[0], 0, file->handle(), 0, left, SPLICE_F_MOVE);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0) {
+            _errorString = tr("Could not write to %1: %2").arg(_fileName, QString::fromLocal8Bit(strerror(errno)));
+            return -1;
+        }
+        left -= written;
+    }
+    return received;
+}
+
+
+qint64 TransferThread::writeFromFile(QTcpSocket *socket, QFile *file)
+{
+    int socketFd = socket->socketDescriptor();
+    pollfd pfd = { socketFd, POLLOUT, 0 };
+    int ready = poll(&pfd, 1, pollInterval);
+    if (ready <= 0)
+        return 0;
+    if (pfd.revents & (POLLERR|POLLHUP))
+        return -1;
+
+    off_t offset = _transferred;
+    ssize_t sent = sendfile(socketFd, file->handle(), &offset, qMin<quint64>(chunkSize, _fileSize - _transferred));
+    if (sent < 0) {
+        if (errno == EAGAIN || errno == EINTR)
+            return 0;
+        _errorString = tr("DCC connection error: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+        return -1;
+    }
+    if (!sent) {
+        _errorString = tr("%1 was truncated while sending it").arg(_fileName);
+        return -1;
+    }
+    return sent;
+}
+
+
+void TransferThread::writeAck(QTcpSocket *socket)
+{
+    // acks are only informational, so never wait for them to be sent
+    quint32 ack = qToBigEndian((quint32)_transferred);
+    send(socket->socketDescriptor(), &ack, sizeof(ack), MSG_NOSIGNAL|MSG_DONTWAIT);
+}
+
+
+bool TransferThread::readAcks(QTcpSocket *socket, int timeout)
+{
+    int socketFd = socket->socketDescriptor();
+    pollfd pfd = { socketFd, POLLIN, 0 };
+    if (poll(&pfd, 1, timeout) <= 0)
+        return true;
+
+    char buf[256];
+    ssize_t received = recv(socketFd, buf, sizeof(buf), MSG_DONTWAIT);
+    if (received < 0)
+        return errno == EAGAIN || errno == EINTR;
+    if (!received)
+        return false;
+
+    _ackBuffer.append(buf, received);
+    parseAcks();
+    return true;
+}
+
+#else
+
+qint64 TransferThread::readIntoFile(QTcpSocket *socket, QFile *file)
+{
+    if (!socket->bytesAvailable() && !socket->waitForReadyRead(pollInterval))
+        return socket->state() == QAbstractSocket::ConnectedState ? 0 : -1;
+
+    QByteArray data = socket->read(chunkSize);
+    if (file->write(data) != data.size()) {
+        _errorString = tr("Could not write to %1: %2").arg(_fileName, file->errorString());
+        return -1;
+    }
+    return data.size();
+}
+
+
+qint64 TransferThread::writeFromFile(QTcpSocket *socket, QFile *file)
+{
+    // don't read ahead more than a chunk of the file
+    if (socket->bytesToWrite() >= chunkSize) {
+        socket->waitForBytesWritten(pollInterval);
+        return socket->state() == QAbstractSocket::ConnectedState ? 0 : -1;
+    }
+
+    QByteArray data = file->read(qMin<quint64>(chunkSize, _fileSize - _transferred));
+    if (data.isEmpty()) {
+        _errorString = tr("%1 was truncated while sending it").arg(_fileName);
+        return -1;
+    }
+    socket->write(data);
+    socket->flush();
+    return data.size();
+}
+
+
+void TransferThread::writeAck(QTcpSocket *socket)
+{
+    quint32 ack = qToBigEndian((quint32)_transferred);
+    socket->write((const char *)&ack, sizeof(ack));
+    socket->flush();
+}
+
+
+bool TransferThread::readAcks(QTcpSocket *socket, int timeout)
+{
+    // also make sure the rest of the file actually gets sent
+    if (socket->bytesToWrite())
+        socket->waitForBytesWritten(timeout);
+    else if (!socket->bytesAvailable() && timeout)
+        socket->waitForReadyRead(timeout);
+
+    QByteArray data = socket->readAll();
+    if (data.isEmpty())
+        return socket->state() == QAbstractSocket::ConnectedState;
+
+    _ackBuffer.append(data);
+    parseAcks();
+    return true;
+}
+
+#endif
+
+
+void TransferThread::reportProgress()
+{
+    if (_progressTimer.isValid() && _progressTimer.elapsed() < 1000)
+        return;
+
+    _progressTimer.start();
+    emit progress(_transferred);
+}
+
+
+void TransferThread::parseAcks()
+{
+    // only the latest ack is of interest
+    int complete = _ackBuffer.size() - _ackBuffer.size() % 4;
+    if (complete) {
+        _acked = qFromBigEndian<quint32>((const uchar *)_ackBuffer.constData() + complete - 4);
+        _ackBuffer.remove(0, complete);
+    }
+}
@@ -0,0 +1,104 @@
+/***************************************************************************
+ *   Copyright (C) 2005-2015 by the Quassel Project                        *
+ *   devel@quassel-irc.org                                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3.                                           *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.         *
+ ***************************************************************************/
+
+#ifndef TRANSFERTHREAD_H
+#define TRANSFERTHREAD_H
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QThread>
+
+#include "transfer.h"
+
+class QFile;
+class QTcpSocket;
+
+//! Does the DCC part of a transfer stored on the core, without involving the session thread
+/** A receiving thread connects to the sender and writes the file to disk, a sending thread listens
+ *  for the receiver to connect and streams the file to it. On Linux, the data is moved by the kernel
+ *  (splice() and sendfile()) and never copied to userspace.
+ *
+ *  Sending threads also serve completed files to clients. In that case, the receiver has to start
+ *  with the token given to setToken(); other connections are dropped.
+ */
+class TransferThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    TransferThread(Transfer::Direction direction, const QString &fileName, const QHostAddress &address, quint16 port, quint64 fileSize = 0, QObject *parent = 0);
+
+    //! Makes a receiving thread fail once it got more than sizeLimit bytes (0 means no limit)
+    inline void setSizeLimit(quint64 sizeLimit) { _sizeLimit = sizeLimit; }
+
+    //! Makes a sending thread only accept a receiver that sends this token first
+    inline void setToken(const QByteArray &token) { _token = token; }
+
+    //! Makes the thread stop transferring and finish as soon as possible
+    void abort();
+
+    void run();
+
+signals:
+    //! Emitted by sending threads once the receiver can connect
+    void listening(quint16 port);
+    void transferStarted();
+    //! Reports the number of bytes transferred so far, about once a second
+    void progress(quint64 transferred);
+    void transferCompleted(quint64 size);
+    void transferFailed(const QString &errorString);
+
+private:
+    bool isAborted();
+
+    QTcpSocket *connectToSender();
+    QTcpSocket *acceptReceiver();
+    bool isValidToken(const QByteArray &token) const;
+    bool receiveFile(QTcpSocket *socket, QFile *file);
+    bool sendFile(QTcpSocket *socket, QFile *file);
+
+    // The platform-dependent parts. Each of these waits for the socket for a short while at most,
+    // returns the number of bytes moved (0 if the socket wasn't ready) or -1 if the connection is gone.
+    qint64 readIntoFile(QTcpSocket *socket, QFile *file);
+    qint64 writeFromFile(QTcpSocket *socket, QFile *file);
+    void writeAck(QTcpSocket *socket);
+    bool readAcks(QTcpSocket *socket, int timeout);
+    void parseAcks();
+    void reportProgress();
+
+    Transfer::Direction _direction;
+    QString _fileName;
+    QHostAddress _address;
+    quint16 _port;
+    quint64 _fileSize;
+    quint64 _sizeLimit;
+    QByteArray _token;
+
+    QAtomicInt _aborted;
+    quint64 _transferred;
+    QElapsedTimer _progressTimer;
+    quint32 _acked;
+    QByteArray _ackBuffer;
+    QString _errorString;
+    int _pipe[2];
+};
+
+#endif
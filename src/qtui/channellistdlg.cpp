@@ -37,8 +37,6 @@ ChannelListDlg::ChannelListDlg(QWidget *parent)
     _advancedMode(false)
 {
     _sortFilter.setSourceModel(&_ircListModel);
-    _sortFilter.setFilterCaseSensitivity(Qt::CaseInsensitive);
-    _sortFilter.setFilterKeyColumn(-1);
 
     ui.setupUi(this);
     ui.advancedModeLabel->setPixmap(QIcon::fromTheme("edit-rename").pixmap(22));
@@ -59,9 +57,11 @@ ChannelListDlg::ChannelListDlg(QWidget *parent)
     connect(ui.advancedModeLabel, SIGNAL(clicked()), this, SLOT(toggleMode()));
     connect(ui.searchChannelsButton, SIGNAL(clicked()), this, SLOT(requestSearch()));
     connect(ui.channelNameLineEdit, SIGNAL(returnPressed()), this, SLOT(requestSearch()));
-    connect(ui.filterLineEdit, SIGNAL(textChanged(QString)), &_sortFilter, SLOT(setFilterFixedString(QString)));
+    connect(ui.filterLineEdit, SIGNAL(textChanged(QString)), &_sortFilter, SLOT(setFilterString(QString)));
     connect(Client::ircListHelper(), SIGNAL(channelListReceived(const NetworkId &, const QStringList &, QList<IrcListHelper::ChannelDescription> )),
         this, SLOT(receiveChannelList(NetworkId, QStringList, QList<IrcListHelper::ChannelDescription> )));
+    connect(Client::ircListHelper(), SIGNAL(channelListPageReceived(const NetworkId &, const QStringList &, QList<IrcListHelper::ChannelDescription> )),
+        this, SLOT(receiveChannelListPage(NetworkId, QStringList, QList<IrcListHelper::ChannelDescription> )));
     connect(Client::ircListHelper(), SIGNAL(finishedListReported(const NetworkId &)), this, SLOT(reportFinishedList()));
     connect(Client::ircListHelper(), SIGNAL(errorReported(const QString &)), this, SLOT(showError(const QString &)));
     connect(ui.channelListView, SIGNAL(activated(QModelIndex)), this, SLOT(joinChannel(QModelIndex)));
@@ -91,6 +91,10 @@ void ChannelListDlg::requestSearch()
     showErrors(false);
     QStringList channelFilters;
     channelFilters << ui.channelNameLineEdit->text().trimmed();
+    if (Client::coreFeatures().testFlag(Quassel::PagedChannelList)) {
+        // results will be appended page by page as they come in
+        _ircListModel.setChannelList();
+    }
     Client::ircListHelper()->requestChannelList(_netId, channelFilters);
 }
 
@@ -107,6 +111,17 @@ void ChannelListDlg::receiveChannelList(const NetworkId &netId, const QStringLis
 }
 
 
+void ChannelListDlg::receiveChannelListPage(const NetworkId &netId, const QStringList &channelFilters, const QList<IrcListHelper::ChannelDescription> &channelList)
+{
+    Q_UNUSED(channelFilters)
+    if (netId != _netId)
+        return;
+
+    showFilterLine(true);
+    _ircListModel.appendChannels(channelList);
+}
+
+
 void ChannelListDlg::showFilterLine(bool show)
 {
     ui.line->setVisible(show);
@@ -161,6 +176,9 @@ void ChannelListDlg::showErrors(bool show)
 void ChannelListDlg::reportFinishedList()
 {
     _listFinished = true;
+    // with paged lists, all data has arrived by the time this is reported
+    if (Client::coreFeatures().testFlag(Quassel::PagedChannelList))
+        enableQuery(true);
 }
 
 
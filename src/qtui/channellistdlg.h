@@ -23,12 +23,11 @@
 
 #include "ui_channellistdlg.h"
 
+#include "irclistfilter.h"
 #include "irclisthelper.h"
 #include "irclistmodel.h"
 #include "types.h"
 
-#include <QSortFilterProxyModel>
-
 class QSpacerItem;
 
 class ChannelListDlg : public QDialog
@@ -43,6 +42,7 @@ public:
 protected slots:
     void requestSearch();
     void receiveChannelList(const NetworkId &netId, const QStringList &channelFilters, const QList<IrcListHelper::ChannelDescription> &channelList);
+    void receiveChannelListPage(const NetworkId &netId, const QStringList &channelFilters, const QList<IrcListHelper::ChannelDescription> &channelList);
     void reportFinishedList();
     void joinChannel(const QModelIndex &);
 
@@ -61,7 +61,7 @@ private:
     bool _listFinished;
     NetworkId _netId;
     IrcListModel _ircListModel;
-    QSortFilterProxyModel _sortFilter;
+    IrcListFilter _sortFilter;
     QSpacerItem *_simpleModeSpacer;
     bool _advancedMode;
 };
@@ -27,6 +27,7 @@ ChatLineModel::ChatLineModel(QObject *parent)
 {
     qRegisterMetaType<WrapList>("ChatLineModel::WrapList");
     qRegisterMetaTypeStreamOperators<WrapList>("ChatLineModel::WrapList");
+    qRegisterMetaType<ClickableList>("ClickableList");
 
     connect(QtUi::style(), SIGNAL(changed()), SLOT(styleChanged()));
 }
@@ -39,12 +40,49 @@ ChatLineModel::ChatLineModel(QObject *parent)
 void ChatLineModel::insertMessages__(int pos, const QList<Message> &messages)
 {
     for (int i = 0; i < messages.count(); i++) {
-        _messageList.insert(pos, ChatLineModelItem(messages[i]));
+        _messageList.insert(pos, ChatLineModelItem(compact(messages[i])));
         pos++;
     }
 }
 
 
+void ChatLineModel::removeAllMessages()
+{
+    _messageList.clear();
+    _bufferInfos.clear();
+    _senders.clear();
+}
+
+
+Message ChatLineModel::compact(const Message &msg)
+{
+    Message compactMsg(msg);
+
+    const BufferInfo &bufferInfo = msg.bufferInfo();
+    QHash<BufferId, BufferInfo>::iterator knownInfo = _bufferInfos.find(bufferInfo.bufferId());
+    if (knownInfo == _bufferInfos.end()) {
+        _bufferInfos.insert(bufferInfo.bufferId(), bufferInfo);
+    }
+    else if (knownInfo->bufferName() != bufferInfo.bufferName() || knownInfo->networkId() != bufferInfo.networkId()
+             || knownInfo->type() != bufferInfo.type() || knownInfo->groupId() != bufferInfo.groupId()) {
+        *knownInfo = bufferInfo; // renamed or otherwise changed; newer messages carry the new info
+    }
+    else {
+        compactMsg.setBufferInfo(*knownInfo);
+    }
+
+    if (!msg.sender().isEmpty()) {
+        QSet<QString>::const_iterator knownSender = _senders.constFind(msg.sender());
+        if (knownSender == _senders.constEnd())
+            _senders.insert(msg.sender());
+        else
+            compactMsg.setSender(*knownSender);
+    }
+
+    return compactMsg;
+}
+
+
 Message ChatLineModel::takeMessageAt(int i)
 {
     Message msg = _messageList[i].message();
@@ -55,9 +93,8 @@ Message ChatLineModel::takeMessageAt(int i)
 
 void ChatLineModel::styleChanged()
 {
-    foreach(ChatLineModelItem item, _messageList) {
-        item.invalidateWrapList();
-    }
+    for (int i = 0; i < _messageList.count(); i++)
+        _messageList[i].invalidateWrapList();
     emit dataChanged(index(0, 0), index(rowCount()-1, columnCount()-1));
 }
 
@@ -24,6 +24,7 @@
 #include "messagemodel.h"
 
 #include <QList>
+#include <QSet>
 #include "chatlinemodelitem.h"
 
 class ChatLineModel : public MessageModel
@@ -34,7 +35,8 @@ public:
     enum ChatLineRole {
         WrapListRole = MessageModel::UserRole,
         MsgLabelRole,
-        SelectedBackgroundRole
+        SelectedBackgroundRole,
+        ClickablesRole
     };
 
     ChatLineModel(QObject *parent = 0);
@@ -52,17 +54,24 @@ protected:
     virtual inline MessageModelItem *firstMessageItem() { return &_messageList.first(); }
     virtual inline const MessageModelItem *lastMessageItem() const { return &_messageList.last(); }
     virtual inline MessageModelItem *lastMessageItem() { return &_messageList.last(); }
-    virtual inline void insertMessage__(int pos, const Message &msg) { _messageList.insert(pos, ChatLineModelItem(msg)); }
+    virtual inline void insertMessage__(int pos, const Message &msg) { _messageList.insert(pos, ChatLineModelItem(compact(msg))); }
     virtual void insertMessages__(int pos, const QList<Message> &);
     virtual inline void removeMessageAt(int i) { _messageList.removeAt(i); }
-    virtual inline void removeAllMessages() { _messageList.clear(); }
+    virtual void removeAllMessages();
     virtual Message takeMessageAt(int i);
 
 protected slots:
     virtual void styleChanged();
 
 private:
+    //! Makes the message share its buffer info and sender with the other messages we store
+    Message compact(const Message &msg);
+
     QList<ChatLineModelItem> _messageList;
+
+    // Every received message brings its own copies of these, which add up quickly for large backlogs
+    QHash<BufferId, BufferInfo> _bufferInfos;
+    QSet<QString> _senders;
 };
 
 
@@ -45,6 +45,7 @@ int ChatLineModelItem::TextBoundaryFinderBufferSize = 512 * (sizeof(HB_CharAttri
 // ****************************************
 ChatLineModelItem::ChatLineModelItem(const Message &msg)
     : MessageModelItem(),
+    _clickablesFound(false),
     _styledMsg(msg)
 {
     if (!msg.sender().contains('!'))
@@ -144,6 +145,12 @@ QVariant ChatLineModelItem::contentsData(int role) const
         if (_wrapList.isEmpty())
             computeWrapList();
         return QVariant::fromValue<ChatLineModel::WrapList>(_wrapList);
+    case ChatLineModel::ClickablesRole:
+        if (!_clickablesFound) {
+            _clickables = ClickableList::fromString(_styledMsg.plainContents());
+            _clickablesFound = true;
+        }
+        return QVariant::fromValue<ClickableList>(_clickables);
     }
     return QVariant();
 }
@@ -23,6 +23,7 @@
 
 #include "messagemodel.h"
 
+#include "clickable.h"
 #include "uistyle.h"
 
 class ChatLineModelItem : public MessageModelItem
@@ -34,7 +35,8 @@ public:
     virtual bool setData(int column, const QVariant &value, int role);
 
     virtual inline const Message &message() const { return _styledMsg; }
-    virtual inline const QDateTime &timestamp() const { return _styledMsg.timestamp(); }
+    virtual inline QDateTime timestamp() const { return _styledMsg.timestamp(); }
+    virtual inline qint64 timestampMsecs() const { return _styledMsg.timestampMsecs(); }
     virtual inline const MsgId &msgId() const { return _styledMsg.msgId(); }
     virtual inline const BufferId &bufferId() const { return _styledMsg.bufferId(); }
     virtual inline void setBufferId(BufferId bufferId) { _styledMsg.setBufferId(bufferId); }
@@ -63,6 +65,9 @@ private:
     void computeWrapList() const;
 
     mutable WrapList _wrapList;
+    // Clickables only depend on the plain contents, so we find them once and keep them for the item's lifetime
+    mutable ClickableList _clickables;
+    mutable bool _clickablesFound;
     UiStyle::StyledMessage _styledMsg;
 
     static unsigned char *TextBoundaryFinderBuffer;
@@ -31,6 +31,7 @@
 #include "qtui.h"
 #include "qtuistyle.h"
 #include "clientignorelistmanager.h"
+#include "startupprofiler.h"
 
 #include "chatline.h"
 
@@ -124,6 +125,15 @@ bool ChatView::event(QEvent *event)
 }
 
 
+void ChatView::paintEvent(QPaintEvent *event)
+{
+    QGraphicsView::paintEvent(event);
+
+    if (StartupProfiler::isEnabled() && scene()->lastLine())
+        StartupProfiler::mark("First chat view paint");
+}
+
+
 void ChatView::resizeEvent(QResizeEvent *event)
 {
     // if view is currently scrolled to bottom, we want it that way after resizing
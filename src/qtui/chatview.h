@@ -92,6 +92,7 @@ public slots:
 protected:
     virtual bool event(QEvent *event);
     virtual void resizeEvent(QResizeEvent *event);
+    virtual void paintEvent(QPaintEvent *event);
     virtual void scrollContentsBy(int dx, int dy);
 
 protected slots:
@@ -28,6 +28,7 @@
 #include "qtuimessageprocessor.h"
 #include "qtuisettings.h"
 #include "qtuistyle.h"
+#include "startupprofiler.h"
 #include "systemtray.h"
 #include "toolbaractionprovider.h"
 #include "types.h"
@@ -56,8 +57,12 @@ QtUi::QtUi() : GraphicalUi()
     setContextMenuActionProvider(new ContextMenuActionProvider(this));
     setToolBarActionProvider(new ToolBarActionProvider(this));
 
+    StartupProfiler::begin("Stylesheet loading");
     setUiStyle(new QtUiStyle(this));
+    StartupProfiler::end("Stylesheet loading");
+    StartupProfiler::begin("MainWin construction");
     _mainWin = new MainWin();
+    StartupProfiler::end("MainWin construction");
 
     setMainWidget(_mainWin);
 
@@ -22,6 +22,7 @@
 
 #include <QIcon>
 #include <QStringList>
+#include <QTimer>
 
 #ifdef HAVE_KDE4
 #  include <KStandardDirs>
@@ -32,6 +33,7 @@
 #include "mainwin.h"
 #include "qtui.h"
 #include "qtuisettings.h"
+#include "startupprofiler.h"
 
 
 QtUiApplication::QtUiApplication(int &argc, char **argv)
@@ -97,6 +99,14 @@ QtUiApplication::QtUiApplication(int &argc, char **argv)
 
 bool QtUiApplication::init()
 {
+    if (Quassel::isOptionSet("profile-startup") || Quassel::isOptionSet("startup-benchmark")) {
+        StartupProfiler::enable(Quassel::isOptionSet("startup-benchmark"));
+        StartupProfiler::setCompletionEvents(QStringList() << "Initial backlog" << "First chat view paint");
+        // don't leave benchmark scripts hanging if e.g. no chat view ever gets painted
+        if (Quassel::isOptionSet("startup-benchmark"))
+            QTimer::singleShot(Quassel::optionValue("startup-benchmark-timeout").toInt() * 1000, this, SLOT(startupTimedOut()));
+    }
+
     if (Quassel::init()) {
         // FIXME: MIGRATION 0.3 -> 0.4: Move database and core config to new location
         // Move settings, note this does not delete the old files
@@ -150,11 +160,17 @@ bool QtUiApplication::init()
             QIcon::setThemeName("oxygen");
 
         // session resume
+        StartupProfiler::begin("QtUi construction");
         QtUi *gui = new QtUi();
+        StartupProfiler::end("QtUi construction");
+        StartupProfiler::begin("Client initialization");
         Client::init(gui);
+        StartupProfiler::end("Client initialization");
         // init gui only after the event loop has started
         // QTimer::singleShot(0, gui, SLOT(init()));
+        StartupProfiler::begin("QtUi initialization");
         gui->init();
+        StartupProfiler::end("QtUi initialization");
         resumeSessionIfPossible();
         return true;
     }
@@ -168,6 +184,12 @@ QtUiApplication::~QtUiApplication()
 }
 
 
+void QtUiApplication::startupTimedOut()
+{
+    StartupProfiler::abort();
+}
+
+
 void QtUiApplication::quit()
 {
     QtUi::mainWindow()->quit();
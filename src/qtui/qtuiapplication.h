@@ -58,6 +58,9 @@ public:
 protected:
     virtual void quit();
 
+private slots:
+    void startupTimedOut();
+
 private:
     bool _aboutToQuit;
 };
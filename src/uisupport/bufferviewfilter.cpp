@@ -20,6 +20,7 @@
 
 #include "bufferviewfilter.h"
 
+#include <QAbstractProxyModel>
 #include <QApplication>
 #include <QPalette>
 #include <QBrush>
@@ -50,7 +51,8 @@ BufferViewFilter::BufferViewFilter(QAbstractItemModel *model, BufferViewConfig *
     _sortOrder(Qt::AscendingOrder),
     _showServerQueries(false),
     _editMode(false),
-    _enableEditMode(tr("Show / Hide Chats"), this)
+    _enableEditMode(tr("Show / Hide Chats"), this),
+    _bufferListChangeHandled(false)
 {
     setConfig(config);
     setSourceModel(model);
@@ -105,7 +107,11 @@ void BufferViewFilter::configInitialized()
         return;
 
 //   connect(config(), SIGNAL(bufferViewNameSet(const QString &)), this, SLOT(invalidate()));
-    connect(config(), SIGNAL(configChanged()), this, SLOT(invalidate()));
+    connect(config(), SIGNAL(configChanged()), this, SLOT(configUpdated()));
+    connect(config(), SIGNAL(bufferAdded(const BufferId &, int)), this, SLOT(bufferListChanged(const BufferId &)));
+    connect(config(), SIGNAL(bufferRemoved(const BufferId &)), this, SLOT(bufferListChanged(const BufferId &)));
+    connect(config(), SIGNAL(bufferPermanentlyRemoved(const BufferId &)), this, SLOT(bufferListChanged(const BufferId &)));
+    connect(config(), SIGNAL(bufferMoved(const BufferId &, int)), this, SLOT(bufferMoved()));
 //   connect(config(), SIGNAL(networkIdSet(const NetworkId &)), this, SLOT(invalidate()));
 //   connect(config(), SIGNAL(addNewBuffersAutomaticallySet(bool)), this, SLOT(invalidate()));
 //   connect(config(), SIGNAL(sortAlphabeticallySet(bool)), this, SLOT(invalidate()));
@@ -127,6 +133,37 @@ void BufferViewFilter::configInitialized()
 }
 
 
+void BufferViewFilter::configUpdated()
+{
+    // BufferViewConfig emits configChanged() right after every change of the buffer list.
+    // Those have already been handled for the affected row alone, so don't refilter everything.
+    if (_bufferListChangeHandled) {
+        _bufferListChangeHandled = false;
+        return;
+    }
+    invalidate();
+}
+
+
+void BufferViewFilter::bufferListChanged(const BufferId &bufferId)
+{
+    QModelIndex source_index = sourceBufferIndex(bufferId);
+    if (!source_index.isValid())
+        return; // not in our source model (yet), configUpdated() falls back to a full invalidate
+
+    _bufferListChangeHandled = true;
+    emit _dataChanged(source_index, source_index);
+}
+
+
+void BufferViewFilter::bufferMoved()
+{
+    _bufferListChangeHandled = true;
+    if (sortColumn() >= 0)
+        sort(sortColumn(), _sortOrder);
+}
+
+
 void BufferViewFilter::showServerQueriesChanged()
 {
     BufferSettings bufferSettings;
@@ -231,7 +268,7 @@ bool BufferViewFilter::dropMimeData(const QMimeData *data, Qt::DropAction action
             if (row < rowCount(parent)) {
                 QModelIndex source_child = mapToSource(index(row, 0, parent));
                 BufferId beforeBufferId = sourceModel()->data(source_child, NetworkModel::BufferIdRole).value<BufferId>();
-                pos = config()->bufferList().indexOf(beforeBufferId);
+                pos = config()->bufferPosition(beforeBufferId);
                 if (_sortOrder == Qt::DescendingOrder)
                     pos++;
             }
@@ -242,8 +279,8 @@ bool BufferViewFilter::dropMimeData(const QMimeData *data, Qt::DropAction action
                     pos = 0;
             }
 
-            if (config()->bufferList().contains(bufferId) && !config()->sortAlphabetically()) {
-                if (config()->bufferList().indexOf(bufferId) < pos)
+            if (config()->containsBuffer(bufferId) && !config()->sortAlphabetically()) {
+                if (config()->bufferPosition(bufferId) < pos)
                     pos--;
                 ClientBufferViewConfig *clientConf = qobject_cast<ClientBufferViewConfig *>(config());
                 if (!clientConf || !clientConf->isLocked())
@@ -270,7 +307,7 @@ void BufferViewFilter::sort(int column, Qt::SortOrder order)
 
 void BufferViewFilter::addBuffer(const BufferId &bufferId) const
 {
-    if (!config() || config()->bufferList().contains(bufferId))
+    if (!config() || config()->containsBuffer(bufferId))
         return;
 
     int pos = config()->bufferList().count();
@@ -319,18 +356,58 @@ void BufferViewFilter::addBuffers(const QList<BufferId> &bufferIds) const
 }
 
 
-bool BufferViewFilter::filterAcceptBuffer(const QModelIndex &source_bufferIndex) const
+// walks down to the NetworkModel, so we can access the items themselves rather than going through data()
+QModelIndex BufferViewFilter::networkModelIndex(const QModelIndex &source_index)
+{
+    QModelIndex index = source_index;
+    const QAbstractProxyModel *proxy;
+    while ((proxy = qobject_cast<const QAbstractProxyModel *>(index.model())))
+        index = proxy->mapToSource(index);
+    return index;
+}
+
+
+const BufferItem *BufferViewFilter::sourceBufferItem(const QModelIndex &source_index) const
+{
+    return Client::networkModel()->bufferItemByIndex(networkModelIndex(source_index));
+}
+
+
+const NetworkItem *BufferViewFilter::sourceNetworkItem(const QModelIndex &source_index) const
+{
+    return Client::networkModel()->networkItemByIndex(networkModelIndex(source_index));
+}
+
+
+QModelIndex BufferViewFilter::sourceBufferIndex(const BufferId &bufferId) const
+{
+    QList<QAbstractProxyModel *> proxies;
+    QAbstractProxyModel *proxy = qobject_cast<QAbstractProxyModel *>(sourceModel());
+    while (proxy) {
+        proxies.prepend(proxy);
+        proxy = qobject_cast<QAbstractProxyModel *>(proxy->sourceModel());
+    }
+
+    QModelIndex index = Client::networkModel()->bufferIndex(bufferId);
+    foreach(QAbstractProxyModel *proxy, proxies) {
+        index = proxy->mapFromSource(index);
+    }
+    return index;
+}
+
+
+bool BufferViewFilter::filterAcceptBuffer(const BufferItem *bufferItem) const
 {
     // no config -> "all buffers" -> accept everything
     if (!config())
         return true;
 
-    BufferId bufferId = sourceModel()->data(source_bufferIndex, NetworkModel::BufferIdRole).value<BufferId>();
+    BufferId bufferId = bufferItem->bufferId();
     Q_ASSERT(bufferId.isValid());
 
-    int activityLevel = sourceModel()->data(source_bufferIndex, NetworkModel::BufferActivityRole).toInt();
+    int activityLevel = bufferItem->activityLevel();
 
-    if (!config()->bufferList().contains(bufferId) && !_editMode) {
+    if (!config()->containsBuffer(bufferId) && !_editMode) {
         // add the buffer if...
         if (config()->isInitialized()
             && !config()->removedBuffers().contains(bufferId) // it hasn't been manually removed and either
@@ -342,26 +419,25 @@ bool BufferViewFilter::filterAcceptBuffer(const QModelIndex &source_bufferIndex)
         return false;
     }
 
-    if (config()->networkId().isValid() && config()->networkId() != sourceModel()->data(source_bufferIndex, NetworkModel::NetworkIdRole).value<NetworkId>())
+    if (config()->networkId().isValid() && config()->networkId() != bufferItem->bufferInfo().networkId())
         return false;
 
     int allowedBufferTypes = config()->allowedBufferTypes();
     if (!config()->networkId().isValid())
         allowedBufferTypes &= ~BufferInfo::StatusBuffer;
-    int bufferType = sourceModel()->data(source_bufferIndex, NetworkModel::BufferTypeRole).toInt();
+    int bufferType = bufferItem->bufferType();
     if (!(allowedBufferTypes & bufferType))
         return false;
 
-    if (bufferType & BufferInfo::QueryBuffer && !_showServerQueries && sourceModel()->data(source_bufferIndex, Qt::DisplayRole).toString().contains('.')) {
+    if (bufferType & BufferInfo::QueryBuffer && !_showServerQueries && bufferItem->bufferName().contains('.')) {
         return false;
     }
 
     // the following dynamic filters may not trigger if the buffer is currently selected.
-    QModelIndex currentIndex = Client::bufferModel()->standardSelectionModel()->currentIndex();
-    if (bufferId == Client::bufferModel()->data(currentIndex, NetworkModel::BufferIdRole).value<BufferId>())
+    if (bufferId == Client::bufferModel()->currentBuffer())
         return true;
 
-    if (config()->hideInactiveBuffers() && !sourceModel()->data(source_bufferIndex, NetworkModel::ItemActiveRole).toBool() && activityLevel <= BufferInfo::OtherActivity)
+    if (config()->hideInactiveBuffers() && !bufferItem->isActive() && activityLevel <= BufferInfo::OtherActivity)
         return false;
 
     if (config()->minimumActivity() > activityLevel)
@@ -371,12 +447,12 @@ bool BufferViewFilter::filterAcceptBuffer(const QModelIndex &source_bufferIndex)
 }
 
 
-bool BufferViewFilter::filterAcceptNetwork(const QModelIndex &source_index) const
+bool BufferViewFilter::filterAcceptNetwork(const NetworkItem *networkItem) const
 {
     if (!config())
         return true;
 
-    if (config()->hideInactiveNetworks() && !(sourceModel()->data(source_index, NetworkModel::ItemActiveRole).toBool())) {
+    if (config()->hideInactiveNetworks() && !networkItem->isActive()) {
         return false;
     }
 
@@ -384,7 +460,7 @@ bool BufferViewFilter::filterAcceptNetwork(const QModelIndex &source_index) cons
         return true;
     }
     else {
-        return config()->networkId() == sourceModel()->data(source_index, NetworkModel::NetworkIdRole).value<NetworkId>();
+        return config()->networkId() == networkItem->networkId();
     }
 }
 
@@ -398,41 +474,42 @@ bool BufferViewFilter::filterAcceptsRow(int source_row, const QModelIndex &sourc
         return false;
     }
 
-    NetworkModel::ItemType childType = (NetworkModel::ItemType)sourceModel()->data(child, NetworkModel::ItemTypeRole).toInt();
-    switch (childType) {
-    case NetworkModel::NetworkItemType:
-        return filterAcceptNetwork(child);
-    case NetworkModel::BufferItemType:
-        return filterAcceptBuffer(child);
-    default:
-        return false;
-    }
+    const BufferItem *bufferItem = sourceBufferItem(child);
+    if (bufferItem)
+        return filterAcceptBuffer(bufferItem);
+
+    const NetworkItem *networkItem = sourceNetworkItem(child);
+    if (networkItem)
+        return filterAcceptNetwork(networkItem);
+
+    return false;
 }
 
 
 bool BufferViewFilter::lessThan(const QModelIndex &source_left, const QModelIndex &source_right) const
 {
-    int leftItemType = sourceModel()->data(source_left, NetworkModel::ItemTypeRole).toInt();
-    int rightItemType = sourceModel()->data(source_right, NetworkModel::ItemTypeRole).toInt();
-    int itemType = leftItemType & rightItemType;
-    switch (itemType) {
-    case NetworkModel::NetworkItemType:
-        return networkLessThan(source_left, source_right);
-    case NetworkModel::BufferItemType:
+    if (sourceBufferItem(source_left) && sourceBufferItem(source_right))
         return bufferLessThan(source_left, source_right);
-    default:
-        return QSortFilterProxyModel::lessThan(source_left, source_right);
-    }
+
+    if (sourceNetworkItem(source_left) && sourceNetworkItem(source_right))
+        return networkLessThan(source_left, source_right);
+
+    return QSortFilterProxyModel::lessThan(source_left, source_right);
 }
 
 
 bool BufferViewFilter::bufferLessThan(const QModelIndex &source_left, const QModelIndex &source_right) const
 {
-    BufferId leftBufferId = sourceModel()->data(source_left, NetworkModel::BufferIdRole).value<BufferId>();
-    BufferId rightBufferId = sourceModel()->data(source_right, NetworkModel::BufferIdRole).value<BufferId>();
+    const BufferItem *leftItem = sourceBufferItem(source_left);
+    const BufferItem *rightItem = sourceBufferItem(source_right);
+    if (!leftItem || !rightItem)
+        return QSortFilterProxyModel::lessThan(source_left, source_right);
+
+    BufferId leftBufferId = leftItem->bufferId();
+    BufferId rightBufferId = rightItem->bufferId();
     if (config()) {
-        int leftPos = config()->bufferList().indexOf(leftBufferId);
-        int rightPos = config()->bufferList().indexOf(rightBufferId);
+        int leftPos = config()->bufferPosition(leftBufferId);
+        int rightPos = config()->bufferPosition(rightBufferId);
         if (leftPos == -1 && rightPos == -1)
             return QSortFilterProxyModel::lessThan(source_left, source_right);
         if (leftPos == -1 || rightPos == -1)
@@ -490,7 +567,7 @@ QVariant BufferViewFilter::checkedState(const QModelIndex &index) const
     if (_toRemove.contains(bufferId))
         return Qt::Unchecked;
 
-    if (config()->bufferList().contains(bufferId))
+    if (config()->containsBuffer(bufferId))
         return Qt::Checked;
 
     if (config()->temporarilyRemovedBuffers().contains(bufferId))
@@ -576,14 +653,11 @@ bool BufferViewFilter::bufferIdLessThan(const BufferId &left, const BufferId &ri
     if (!Client::networkModel())
         return true;
 
-    QModelIndex leftIndex = Client::networkModel()->bufferIndex(left);
-    QModelIndex rightIndex = Client::networkModel()->bufferIndex(right);
-
-    int leftType = Client::networkModel()->data(leftIndex, NetworkModel::BufferTypeRole).toInt();
-    int rightType = Client::networkModel()->data(rightIndex, NetworkModel::BufferTypeRole).toInt();
+    int leftType = Client::networkModel()->bufferType(left);
+    int rightType = Client::networkModel()->bufferType(right);
 
     if (leftType != rightType)
         return leftType < rightType;
     else
-        return QString::compare(Client::networkModel()->data(leftIndex, Qt::DisplayRole).toString(), Client::networkModel()->data(rightIndex, Qt::DisplayRole).toString(), Qt::CaseInsensitive) < 0;
+        return QString::compare(Client::networkModel()->bufferName(left), Client::networkModel()->bufferName(right), Qt::CaseInsensitive) < 0;
 }
@@ -31,6 +31,9 @@
 #include "types.h"
 #include "bufferviewconfig.h"
 
+class BufferItem;
+class NetworkItem;
+
 /*****************************************
  * Buffer View Filter
  *****************************************/
@@ -87,6 +90,9 @@ signals:
 
 private slots:
     void configInitialized();
+    void configUpdated();
+    void bufferListChanged(const BufferId &bufferId);
+    void bufferMoved();
     void enableEditMode(bool enable);
     void showServerQueriesChanged();
 
@@ -100,9 +106,14 @@ private:
     QSet<BufferId> _toAdd;
     QSet<BufferId> _toTempRemove;
     QSet<BufferId> _toRemove;
-
-    bool filterAcceptBuffer(const QModelIndex &) const;
-    bool filterAcceptNetwork(const QModelIndex &) const;
+    bool _bufferListChangeHandled;
+
+    static QModelIndex networkModelIndex(const QModelIndex &source_index);
+    const BufferItem *sourceBufferItem(const QModelIndex &source_index) const;
+    const NetworkItem *sourceNetworkItem(const QModelIndex &source_index) const;
+    QModelIndex sourceBufferIndex(const BufferId &bufferId) const;
+    bool filterAcceptBuffer(const BufferItem *) const;
+    bool filterAcceptNetwork(const NetworkItem *) const;
     void addBuffer(const BufferId &bufferId) const;
     void addBuffers(const QList<BufferId> &bufferIds) const;
     static bool bufferIdLessThan(const BufferId &, const BufferId &);
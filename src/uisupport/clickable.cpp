@@ -48,72 +48,271 @@ void Clickable::activate(NetworkId networkId, const QString &text) const
 }
 
 
-// NOTE: This method is not threadsafe and not reentrant!
-//       (RegExps are not constant while matching, and they are static here for efficiency)
-ClickableList ClickableList::fromString(const QString &str)
+// The scanner below implements the following patterns, but without a regexp engine: matching them with QRegExp
+// meant backtracking over every single message, which got really expensive for long lines and large backlogs.
+//
+// URL:     \b(SCHEME AUTHORITY (?:/URLCHARS*)?) URLEND, case-insensitive, with
+//          SCHEME    = (?:mailto:|(?:[+.-]?\w)+://)|www(?=\.\S+\.)
+//          AUTHORITY = (?:(?:[,.;@:]?[-\w]+)+\.?|\[[0-9a-f:.]+\])(?::\d+)?
+//          URLCHARS  = (?:[,.;:]*[\w~@/?&=+$()!%#*-])
+//          URLEND    = (?:>|[,.;:"]*\s|\b|$)
+// Channel: ((?:#|![A-Z0-9]{5})[^,:\s]+(?::[^,:\s]+)?)\b
+//          We don't match for channel names starting with + or &, because that gives us a lot of false positives.
+//
+// TODO: Nicks, we'll need a filtering for only matching known nicknames further down if we do this
+
+// \w
+static inline bool isWordChar(const QChar &c)
+{
+    return c.isLetterOrNumber() || c.isMark() || c == '_';
+}
+
+
+// \b
+static inline bool isWordBoundary(const QString &str, int pos)
+{
+    bool before = pos > 0 && isWordChar(str.at(pos - 1));
+    bool after = pos < str.length() && isWordChar(str.at(pos));
+    return before != after;
+}
+
+
+// [\w~@/?&=+$()!%#*-]
+static bool isUrlChar(const QChar &c)
+{
+    switch (c.unicode()) {
+    case '~': case '@': case '/': case '?': case '&': case '=': case '+': case '$':
+    case '(': case ')': case '!': case '%': case '#': case '*': case '-':
+        return true;
+    default:
+        return isWordChar(c);
+    }
+}
+
+
+// [,.;:]
+static inline bool isUrlPunctuation(const QChar &c)
+{
+    return c == ',' || c == '.' || c == ';' || c == ':';
+}
+
+
+// [,:\s]
+static inline bool isChannelStop(const QChar &c)
+{
+    return c == ',' || c == ':' || c.isSpace();
+}
+
+
+static inline bool isAsciiAlphaNumeric(const QChar &c)
+{
+    ushort u = c.unicode();
+    return (u >= '0' && u <= '9') || (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z');
+}
+
+
+static inline bool isHexDigit(const QChar &c)
 {
-    // For matching URLs
-    static QString scheme("(?:(?:mailto:|(?:[+.-]?\\w)+://)|www(?=\\.\\S+\\.))");
-    static QString authority("(?:(?:[,.;@:]?[-\\w]+)+\\.?|\\[[0-9a-f:.]+\\])(?::\\d+)?");
-    static QString urlChars("(?:[,.;:]*[\\w~@/?&=+$()!%#*-])");
-    static QString urlEnd("(?:>|[,.;:\"]*\\s|\\b|$)");
+    ushort u = c.unicode();
+    return (u >= '0' && u <= '9') || (u >= 'a' && u <= 'f') || (u >= 'A' && u <= 'F');
+}
 
-    static QRegExp regExp[] = {
-        // URL
-        // QRegExp(QString("((?:https?://|s?ftp://|irc://|mailto:|www\\.)%1+|%1+\\.[a-z]{2,4}(?:?=/%1+|\\b))%2").arg(urlChars, urlEnd)),
-        QRegExp(QString("\\b(%1%2(?:/%3*)?)%4").arg(scheme, authority, urlChars, urlEnd), Qt::CaseInsensitive),
 
-        // Channel name
-        // We don't match for channel names starting with + or &, because that gives us a lot of false positives.
-        QRegExp("((?:#|![A-Z0-9]{5})[^,:\\s]+(?::[^,:\\s]+)?)\\b", Qt::CaseInsensitive)
+static bool isUrlEnd(const QString &str, int pos)
+{
+    if (pos == str.length() || str.at(pos) == '>')
+        return true;
 
-        // TODO: Nicks, we'll need a filtering for only matching known nicknames further down if we do this
-    };
+    int i = pos;
+    while (i < str.length() && (isUrlPunctuation(str.at(i)) || str.at(i) == '"'))
+        ++i;
+    if (i < str.length() && str.at(i).isSpace())
+        return true;
 
-    static const int regExpCount = 2; // number of regexps in the array above
+    return isWordBoundary(str, pos);
+}
 
-    qint16 matches[] = { 0, 0, 0 };
-    qint16 matchEnd[] = { 0, 0, 0 };
 
+//! Returns the end of the URL whose authority starts at authorityStart, or -1 if there is none
+static int matchUrlAfterScheme(const QString &str, int authorityStart)
+{
+    const int len = str.length();
+    int i = authorityStart;
+    int minEnd = authorityStart + 1;
+    int trailingDotEnd = -1;
+
+    // Authority; an IPv6 address can only be taken as a whole
+    if (i < len && str.at(i) == '[') {
+        int j = i + 1;
+        while (j < len && (isHexDigit(str.at(j)) || str.at(j) == ':' || str.at(j) == '.'))
+            ++j;
+        if (j == i + 1 || j >= len || str.at(j) != ']')
+            return -1;
+        i = minEnd = j + 1;
+    }
+    else {
+        forever {
+            int j = i;
+            if (j < len && (isUrlPunctuation(str.at(j)) || str.at(j) == '@'))
+                ++j;
+            int k = j;
+            while (k < len && (isWordChar(str.at(k)) || str.at(k) == '-'))
+                ++k;
+            if (k == j)
+                break;
+            i = k;
+        }
+        if (i == authorityStart)
+            return -1;
+        if (i < len && str.at(i) == '.')
+            trailingDotEnd = ++i;
+    }
+    if (i + 1 < len && str.at(i) == ':' && str.at(i + 1).isDigit()) {
+        i += 2;
+        while (i < len && str.at(i).isDigit())
+            ++i;
+    }
+
+    // Path; punctuation only counts if it's followed by a proper URL character
+    const int pathStart = i;
+    if (i < len && str.at(i) == '/') {
+        ++i;
+        forever {
+            int j = i;
+            while (j < len && isUrlPunctuation(str.at(j)))
+                ++j;
+            if (j >= len || !isUrlChar(str.at(j)))
+                break;
+            i = j + 1;
+        }
+    }
+
+    // Give back characters until we end at a sensible place; apart from the authority's trailing dot,
+    // separators must be followed by something
+    while (i >= minEnd) {
+        QChar last = str.at(i - 1);
+        bool danglingSeparator = (isUrlPunctuation(last) || (i <= pathStart && last == '@')) && i != trailingDotEnd;
+        if (!danglingSeparator && isUrlEnd(str, i))
+            break;
+        --i;
+    }
+    return i >= minEnd ? i : -1;
+}
+
+
+//! Returns the end of the URL starting at pos, or -1 if there is none
+static int matchUrl(const QString &str, int pos)
+{
+    if (!isWordBoundary(str, pos))
+        return -1;
+
+    // Try the scheme alternatives in the same order as the pattern above
+    const int len = str.length();
+    if (str.midRef(pos, 7).compare(QLatin1String("mailto:"), Qt::CaseInsensitive) == 0) {
+        int end = matchUrlAfterScheme(str, pos + 7);
+        if (end > 0)
+            return end;
+    }
+
+    int i = pos;
+    while (i < len) {
+        QChar c = str.at(i);
+        if (isWordChar(c))
+            ++i;
+        else if ((c == '+' || c == '.' || c == '-') && i + 1 < len && isWordChar(str.at(i + 1)))
+            i += 2;
+        else
+            break;
+    }
+    if (i > pos && str.midRef(i, 3) == QLatin1String("://")) {
+        int end = matchUrlAfterScheme(str, i + 3);
+        if (end > 0)
+            return end;
+    }
+
+    // www(?=\.\S+\.)
+    if (str.midRef(pos, 3).compare(QLatin1String("www"), Qt::CaseInsensitive) != 0
+        || pos + 4 >= len || str.at(pos + 3) != '.' || str.at(pos + 4).isSpace())
+        return -1;
+    i = pos + 5;
+    while (i < len && !str.at(i).isSpace() && str.at(i) != '.')
+        ++i;
+    if (i >= len || str.at(i) != '.')
+        return -1;
+    return matchUrlAfterScheme(str, pos + 3);
+}
+
+
+//! Returns the end of the channel name starting at pos, or -1 if there is none
+static int matchChannel(const QString &str, int pos)
+{
+    const int len = str.length();
+    int i = pos;
+    if (str.at(i) == '#') {
+        ++i;
+    }
+    else if (str.at(i) == '!' && pos + 6 <= len) {
+        for (i = pos + 1; i < pos + 6; ++i) {
+            if (!isAsciiAlphaNumeric(str.at(i)))
+                return -1;
+        }
+    }
+    else {
+        return -1;
+    }
+
+    const int nameStart = i;
+    while (i < len && !isChannelStop(str.at(i)))
+        ++i;
+    if (i == nameStart)
+        return -1;
+    if (i + 1 < len && str.at(i) == ':' && !isChannelStop(str.at(i + 1))) {
+        ++i;
+        while (i < len && !isChannelStop(str.at(i)))
+            ++i;
+    }
+
+    // The name has to end at a word boundary
+    while (i > nameStart && (!isWordBoundary(str, i) || str.at(i - 1) == ':'))
+        --i;
+    return i > nameStart ? i : -1;
+}
+
+
+ClickableList ClickableList::fromString(const QString &str)
+{
     ClickableList result;
-    //QString str = data(ChatLineModel::DisplayRole).toString();
-
-    qint16 idx = 0;
-    qint16 minidx;
-    int type = -1;
-
-    do {
-        type = -1;
-        minidx = str.length();
-        for (int i = 0; i < regExpCount; i++) {
-            if (matches[i] < 0 || matchEnd[i] > str.length()) continue;
-            if (idx >= matchEnd[i]) {
-                matches[i] = regExp[i].indexIn(str, qMax(matchEnd[i], idx));
-                if (matches[i] >= 0) matchEnd[i] = matches[i] + regExp[i].cap(1).length();
-            }
-            if (matches[i] >= 0 && matches[i] < minidx) {
-                minidx = matches[i];
-                type = i;
-            }
+
+    // Clickable only has room for 16 bit positions
+    const int len = qMin(str.length(), 0xffff);
+    int pos = 0;
+    while (pos < len) {
+        int end = matchUrl(str, pos);
+        if (end > 0) {
+            // special case: closing paren only matches if we had an open one
+            if (str.at(end - 1) == ')' && str.lastIndexOf('(', end - 1) < pos)
+                --end;
+            end = qMin(end, len);
+            result.append(Clickable(Clickable::Url, pos, end - pos));
+            pos = end;
+            continue;
         }
-        if (type >= 0) {
-            idx = matchEnd[type];
-            QString match = str.mid(matches[type], matchEnd[type] - matches[type]);
-            if (type == Clickable::Url && str.at(idx-1) == ')') { // special case: closing paren only matches if we had an open one
-                if (!match.contains('(')) {
-                    matchEnd[type]--;
-                    match.chop(1);
-                }
-            }
-            if (type == Clickable::Channel) {
-                // don't make clickable if it could be a #number
-                if (QRegExp("^#\\d+$").exactMatch(match))
-                    continue;
-            }
-            result.append(Clickable((Clickable::Type)type, matches[type], matchEnd[type] - matches[type]));
+
+        end = matchChannel(str, pos);
+        if (end > 0) {
+            end = qMin(end, len);
+            // don't make clickable if it could be a #number
+            bool isNumber = str.at(pos) == '#';
+            for (int i = pos + 1; isNumber && i < end; ++i)
+                isNumber = str.at(i).isDigit();
+            if (!isNumber)
+                result.append(Clickable(Clickable::Channel, pos, end - pos));
+            pos = end;
+            continue;
         }
+
+        ++pos;
     }
-    while (type >= 0);
     return result;
 }
 
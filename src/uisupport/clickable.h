@@ -57,6 +57,9 @@ private:
 };
 
 
+Q_DECLARE_TYPEINFO(Clickable, Q_MOVABLE_TYPE);
+
+
 class ClickableList : public QList<Clickable>
 {
 public:
@@ -66,4 +69,7 @@ public:
 };
 
 
+Q_DECLARE_METATYPE(ClickableList)
+
+
 #endif // CLICKABLE_H_
@@ -670,11 +670,13 @@ void MultiLineEdit::on_returnPressed()
 void MultiLineEdit::on_returnPressed(const QString &text)
 {
     if (!text.isEmpty()) {
-        foreach(const QString &line, text.split('\n', QString::SkipEmptyParts)) {
-            if (line.isEmpty())
-                continue;
-            addToHistory(line);
-            emit textEntered(line);
+        // multiple lines are handed on as one entry, so a large paste costs one round trip instead of
+        // one per line; the history only gets the whole entry if we can show it again
+        QStringList lines = text.split('\n', QString::SkipEmptyParts);
+        if (!lines.isEmpty()) {
+            QString entry = lines.join("\n");
+            addToHistory(_mode == MultiLine ? entry : lines.last());
+            emit textEntered(entry);
         }
         reset();
         _tempHistory.clear();
@@ -720,11 +722,7 @@ void MultiLineEdit::on_textChanged()
                     return;
             }
 
-            foreach(QString line, lines) {
-                clear();
-                insert(line);
-                on_returnPressed();
-            }
+            on_returnPressed(lines.join("\n"));
         }
     }
 
@@ -19,6 +19,8 @@
  ***************************************************************************/
 
 #include <QApplication>
+#include <QCryptographicHash>
+#include <QFile>
 #include <QIcon>
 
 #include "buffersettings.h"
@@ -30,6 +32,18 @@
 
 QHash<QString, UiStyle::FormatType> UiStyle::_formatCodes;
 QString UiStyle::_timestampFormatString;
+QHash<qint64, QString> UiStyle::_timestampCache;
+bool UiStyle::_timestampShowsMsecs = false;
+
+const quint32 compiledStyleSheetMagic = 0x51535343;  // "QSSC"
+const quint32 compiledStyleSheetVersion = 1;         // bump whenever QssParser's output changes
+
+// Dimensions of the flat format tables: message type, message part, sender hash, message label flags
+const int formatTableMsgTypes = 0x40;
+const int formatTableParts = 4;
+const int formatTableSenderHashes = 17;
+const int formatTableLabels = 8;
+const int formatTableSize = formatTableMsgTypes * formatTableParts * formatTableSenderHashes * formatTableLabels;
 
 UiStyle::UiStyle(QObject *parent)
     : QObject(parent),
@@ -82,6 +96,7 @@ UiStyle::UiStyle(QObject *parent)
 
 UiStyle::~UiStyle()
 {
+    qDeleteAll(_metricsTable);
     qDeleteAll(_metricsCache);
 }
 
@@ -94,11 +109,6 @@ void UiStyle::reload()
 
 void UiStyle::loadStyleSheet()
 {
-    qDeleteAll(_metricsCache);
-    _metricsCache.clear();
-    _formatCache.clear();
-    _formats.clear();
-
     UiStyleSettings s;
 
     QString styleSheet;
@@ -122,24 +132,94 @@ void UiStyle::loadStyleSheet()
     }
     styleSheet += loadStyleSheet("file:///" + Quassel::optionValue("qss"), true);
 
-    if (!styleSheet.isEmpty()) {
-        QssParser parser;
-        parser.processStyleSheet(styleSheet);
-        QApplication::setPalette(parser.palette());
+    // If nothing changed, there's no need to throw away our formats and all the layouts based on them
+    QByteArray styleSheetHash = QCryptographicHash::hash(styleSheet.toUtf8(), QCryptographicHash::Sha1);
+    if (styleSheetHash == _styleSheetHash)
+        return;
+    _styleSheetHash = styleSheetHash;
+
+    clearFormatCache();
+    _formats.clear();
 
-        _uiStylePalette = parser.uiStylePalette();
-        _formats = parser.formats();
-        _listItemFormats = parser.listItemFormats();
+    if (!styleSheet.isEmpty()) {
+        // The parser starts out with the current application palette, so that's part of the input as well
+        QByteArray key;
+        QDataStream keyStream(&key, QIODevice::WriteOnly);
+        keyStream.setVersion(QDataStream::Qt_4_2);
+        keyStream << compiledStyleSheetVersion << styleSheetHash << QApplication::palette();
+        QByteArray compiledHash = QCryptographicHash::hash(key, QCryptographicHash::Sha1);
+
+        QPalette palette;
+        QString remainingStyleSheet;
+        if (!loadCompiledStyleSheet(compiledHash, &palette, &remainingStyleSheet)) {
+            QssParser parser;
+            parser.processStyleSheet(styleSheet);
+            palette = parser.palette();
+            _uiStylePalette = parser.uiStylePalette();
+            _formats = parser.formats();
+            _listItemFormats = parser.listItemFormats();
+            remainingStyleSheet = styleSheet.trimmed();
+            saveCompiledStyleSheet(compiledHash, palette, remainingStyleSheet);
+        }
 
-        styleSheet = styleSheet.trimmed();
-        if (!styleSheet.isEmpty())
-            qApp->setStyleSheet(styleSheet);  // pass the remaining sections to the application
+        QApplication::setPalette(palette);
+        if (!remainingStyleSheet.isEmpty())
+            qApp->setStyleSheet(remainingStyleSheet);  // pass the remaining sections to the application
     }
 
     emit changed();
 }
 
 
+bool UiStyle::loadCompiledStyleSheet(const QByteArray &hash, QPalette *palette, QString *remainingStyleSheet)
+{
+    QFile file(Quassel::configDirPath() + "stylesheet.cache");
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_4_2);
+    quint32 magic, version;
+    QByteArray cachedHash;
+    in >> magic >> version >> cachedHash;
+    if (in.status() != QDataStream::Ok || magic != compiledStyleSheetMagic || version != compiledStyleSheetVersion || cachedHash != hash)
+        return false;
+
+    QPalette cachedPalette;
+    QVector<QBrush> uiStylePalette;
+    QHash<quint64, QTextCharFormat> formats;
+    QHash<quint32, QTextCharFormat> listItemFormats;
+    QString remaining;
+    in >> cachedPalette >> uiStylePalette >> formats >> listItemFormats >> remaining;
+    if (in.status() != QDataStream::Ok || uiStylePalette.count() != NumRoles) {
+        qWarning() << "Ignoring corrupt stylesheet cache" << file.fileName();
+        return false;
+    }
+
+    *palette = cachedPalette;
+    *remainingStyleSheet = remaining;
+    _uiStylePalette = uiStylePalette;
+    _formats = formats;
+    _listItemFormats = listItemFormats;
+    return true;
+}
+
+
+void UiStyle::saveCompiledStyleSheet(const QByteArray &hash, const QPalette &palette, const QString &remainingStyleSheet) const
+{
+    QFile file(Quassel::configDirPath() + "stylesheet.cache");
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Could not write stylesheet cache" << file.fileName() << ":" << file.errorString();
+        return;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_4_2);
+    out << compiledStyleSheetMagic << compiledStyleSheetVersion << hash
+        << palette << _uiStylePalette << _formats << _listItemFormats << remainingStyleSheet;
+}
+
+
 QString UiStyle::loadStyleSheet(const QString &styleSheet, bool shouldExist)
 {
     QString ss = styleSheet;
@@ -168,6 +248,8 @@ void UiStyle::setTimestampFormatString(const QString &format)
 {
     if (_timestampFormatString != format) {
         _timestampFormatString = format;
+        _timestampShowsMsecs = format.contains('z');
+        _timestampCache.clear();
         // FIXME reload
     }
 }
@@ -331,21 +413,101 @@ QTextCharFormat UiStyle::format(quint64 key) const
 }
 
 
-QTextCharFormat UiStyle::cachedFormat(quint32 formatType, quint32 messageLabel) const
+// Maps the combinations of format type and message label that are used for laying out and painting
+// every chat line to an index into the flat format tables; returns -1 for everything else.
+int UiStyle::formatTableIndex(quint32 formatType, quint32 messageLabel)
 {
-    return _formatCache.value(formatType | ((quint64)messageLabel << 32), QTextCharFormat());
+    quint32 msgType = formatType & 0x000000ff;
+    if (msgType >= (quint32)formatTableMsgTypes)
+        return -1;
+
+    int part;
+    switch (formatType & 0xffffff00) {
+    case 0:
+        part = 0;
+        break;
+    case Timestamp:
+        part = 1;
+        break;
+    case Sender:
+        part = 2;
+        break;
+    case Contents:
+        part = 3;
+        break;
+    default:
+        return -1;
+    }
+
+    quint32 senderHash = messageLabel >> 16;
+    quint32 labelFlags = messageLabel & 0x0000ffff;
+    if (senderHash >= (quint32)formatTableSenderHashes || labelFlags >= (quint32)formatTableLabels)
+        return -1;
+
+    return ((msgType * formatTableParts + part) * formatTableSenderHashes + senderHash) * formatTableLabels + labelFlags;
+}
+
+
+bool UiStyle::cachedFormat(quint32 formatType, quint32 messageLabel, QTextCharFormat *format) const
+{
+    int index = formatTableIndex(formatType, messageLabel);
+    if (index >= 0) {
+        if (_formatTableValid.isEmpty() || !_formatTableValid.testBit(index))
+            return false;
+        *format = _formatTable.at(index);
+        return true;
+    }
+
+    QHash<quint64, QTextCharFormat>::const_iterator it = _formatCache.constFind(formatType | ((quint64)messageLabel << 32));
+    if (it == _formatCache.constEnd())
+        return false;
+    *format = it.value();
+    return true;
 }
 
 
 void UiStyle::setCachedFormat(const QTextCharFormat &format, quint32 formatType, quint32 messageLabel) const
 {
+    int index = formatTableIndex(formatType, messageLabel);
+    if (index >= 0) {
+        if (_formatTable.isEmpty()) {
+            _formatTable.resize(formatTableSize);
+            _formatTableValid.resize(formatTableSize);
+        }
+        _formatTable[index] = format;
+        _formatTableValid.setBit(index);
+        return;
+    }
+
     _formatCache[formatType | ((quint64)messageLabel << 32)] = format;
 }
 
 
+void UiStyle::clearFormatCache()
+{
+    qDeleteAll(_metricsTable);
+    _metricsTable.clear();
+    qDeleteAll(_metricsCache);
+    _metricsCache.clear();
+    _formatTable.clear();
+    _formatTableValid.clear();
+    _formatCache.clear();
+}
+
+
 QFontMetricsF *UiStyle::fontMetrics(quint32 ftype, quint32 label) const
 {
     // QFontMetricsF is not assignable, so we need to store pointers :/
+    int index = formatTableIndex(ftype, label);
+    if (index >= 0) {
+        if (_metricsTable.isEmpty())
+            _metricsTable.fill(0, formatTableSize);
+        QFontMetricsF *&metrics = _metricsTable[index];
+        if (!metrics)
+            metrics = new QFontMetricsF(format(ftype, label).font());
+        return metrics;
+    }
+
     quint64 key = ftype | ((quint64)label << 32);
 
     if (_metricsCache.contains(key))
@@ -367,8 +529,8 @@ QTextCharFormat UiStyle::format(quint32 ftype, quint32 label_) const
     quint64 label = (quint64)label_ << 32;
 
     // check if we have exactly this format readily cached already
-    QTextCharFormat fmt = cachedFormat(ftype, label_);
-    if (fmt.properties().count())
+    QTextCharFormat fmt;
+    if (cachedFormat(ftype, label_, &fmt))
         return fmt;
 
     mergeFormat(fmt, ftype, label & Q_UINT64_C(0xffff000000000000));
@@ -728,7 +890,7 @@ void UiStyle::StyledMessage::style() const
     case Message::DayChange:
     {
         //: Day Change Message
-        t = tr("{Day changed to %1}").arg(timestamp().date().toString(Qt::DefaultLocaleLongDate));
+        t = tr("{Day changed to %1}").arg(timestamp().toLocalTime().date().toString(Qt::DefaultLocaleLongDate));
     }
         break;
     case Message::Topic:
@@ -770,6 +932,10 @@ void UiStyle::StyledMessage::style() const
         t = QString("[%1]").arg(txt);
     }
     _contents = UiStyle::styleString(t, UiStyle::formatType(type()));
+
+    // for most messages the styled text is just the contents, so share them rather than keeping a copy
+    if (_contents.plainText == contents())
+        _contents.plainText = contents();
 }
 
 
@@ -793,7 +959,18 @@ const UiStyle::FormatList &UiStyle::StyledMessage::contentsFormatList() const
 
 QString UiStyle::StyledMessage::decoratedTimestamp() const
 {
-    return timestamp().toLocalTime().toString(UiStyle::timestampFormatString());
+    // this is asked for on every paint, and lots of messages share their second; formats showing
+    // milliseconds ('z') can only share exact timestamps
+    qint64 key = _timestampShowsMsecs ? timestampMsecs() : timestampMsecs() / 1000 * 1000;
+    QHash<qint64, QString>::const_iterator cached = _timestampCache.constFind(key);
+    if (cached != _timestampCache.constEnd())
+        return *cached;
+
+    if (_timestampCache.count() >= 4096)
+        _timestampCache.clear();
+    QString timestamp = QDateTime::fromMSecsSinceEpoch(key).toString(UiStyle::timestampFormatString());
+    _timestampCache.insert(key, timestamp);
+    return timestamp;
 }
 
 
@@ -21,6 +21,7 @@
 #ifndef UISTYLE_H_
 #define UISTYLE_H_
 
+#include <QBitArray>
 #include <QDataStream>
 #include <QFontMetricsF>
 #include <QHash>
@@ -160,9 +161,14 @@ protected:
     void loadStyleSheet();
     QString loadStyleSheet(const QString &name, bool shouldExist = false);
 
+    //! Loads the result of parsing a stylesheet with the given hash from the disk cache
+    bool loadCompiledStyleSheet(const QByteArray &hash, QPalette *palette, QString *remainingStyleSheet);
+    void saveCompiledStyleSheet(const QByteArray &hash, const QPalette &palette, const QString &remainingStyleSheet) const;
+
     QTextCharFormat format(quint64 key) const;
-    QTextCharFormat cachedFormat(quint32 formatType, quint32 messageLabel) const;
+    bool cachedFormat(quint32 formatType, quint32 messageLabel, QTextCharFormat *format) const;
     void setCachedFormat(const QTextCharFormat &format, quint32 formatType, quint32 messageLabel) const;
+    void clearFormatCache();
     void mergeFormat(QTextCharFormat &format, quint32 formatType, quint64 messageLabel) const;
     void mergeSubElementFormat(QTextCharFormat &format, quint32 formatType, quint64 messageLabel) const;
 
@@ -177,14 +183,25 @@ private slots:
     void showItemViewIconsChanged(const QVariant &);
 
 private:
+    static int formatTableIndex(quint32 formatType, quint32 messageLabel);
+
     QVector<QBrush> _uiStylePalette;
     QBrush _markerLineBrush;
     QHash<quint64, QTextCharFormat> _formats;
+    QByteArray _styleSheetHash;
+
+    // Formats of message types and their timestamp, sender and contents parts are looked up on every
+    // paint, so they are kept in flat tables indexed by formatTableIndex(). Everything else goes to the hashes.
+    mutable QVector<QTextCharFormat> _formatTable;
+    mutable QBitArray _formatTableValid;
+    mutable QVector<QFontMetricsF *> _metricsTable;
     mutable QHash<quint64, QTextCharFormat> _formatCache;
     mutable QHash<quint64, QFontMetricsF *> _metricsCache;
     QHash<quint32, QTextCharFormat> _listItemFormats;
     static QHash<QString, FormatType> _formatCodes;
     static QString _timestampFormatString;
+    static QHash<qint64, QString> _timestampCache; // formatted timestamps by second (or msec), for the current format
+    static bool _timestampShowsMsecs;
 
     QIcon _channelJoinedIcon;
     QIcon _channelPartedIcon;